@@ -0,0 +1,142 @@
+#include "flow.h"
+#include "flow_table.h"
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+/*
+FlowTable的性能测试
+比较100k个flow时，每个时间片发送数据的耗时：
+1. AoS：原来的Flow布局，热字段和std::string protocol，std::vector<int> path混在一起，
+   flow分散在每个gpu的flows里，背景流量通过Flow*访问，与原来的GPU::communication和Network::step相同
+2. SoA：FlowTable::drain，对连续的float数组一次遍历
+*/
+
+// 原来的Flow布局
+struct FlowAoS {
+    pair<int, int> src;
+    pair<int, int> dst;
+    int srcId;
+    int dstId;
+    float completionTime = 0;
+    float chunkDataSize = 0;
+    float sentDataSize = 0;
+    float dataSize = 0;
+    string protocol;
+    float rate = 0;
+    vector<int> path;
+};
+
+// 原来的GPU::communication
+void communicationAoS(vector<FlowAoS>& flows, float unitTime) {
+    for (auto& flow : flows) {
+        if (flow.dataSize > 0) {
+            if (flow.dataSize > flow.rate * unitTime) {
+                flow.dataSize -= flow.rate * unitTime;
+                flow.sentDataSize += flow.rate * unitTime;
+            }
+            else {
+                flow.sentDataSize += flow.dataSize;
+                flow.dataSize = 0;
+            }
+            flow.completionTime += unitTime;
+        }
+    }
+}
+
+// 原来Network::step里背景流量的循环
+void bgStepAoS(vector<FlowAoS*>& bgFlowManager, float unitTime) {
+    for (auto& flow : bgFlowManager) {
+        if (flow->dataSize > 0) {
+            flow->dataSize -= flow->rate * unitTime;
+        }
+        else {
+            flow->dataSize = 0;
+        }
+    }
+}
+
+int main() {
+    int flowNum = 100000;
+    int gpuFlowNum = 2; // 每个gpu有NVLink和Net两个flow
+    int bgFlowNum = flowNum / 10;
+    int gpuTotal = (flowNum - bgFlowNum) / gpuFlowNum;
+    int tickNum = 2000;
+    float unitTime = 1;
+    float dataSize = 1e7; // 足够大，测试期间flow不会发送完
+
+    // 1. AoS
+    vector<vector<FlowAoS>> gpuFlows(gpuTotal);
+    vector<FlowAoS> bgFlows(bgFlowNum);
+    vector<FlowAoS*> bgFlowManager;
+    for (int g = 0; g < gpuTotal; g++) {
+        for (int i = 0; i < gpuFlowNum; i++) {
+            FlowAoS flow;
+            flow.dataSize = dataSize;
+            flow.rate = 0.1f + (g % 7) * 0.01f;
+            flow.protocol = i == 0 ? "NVLink" : "Net";
+            flow.path = {g, g + 1, g + 2, g + 3, g + 4};
+            gpuFlows[g].push_back(flow);
+        }
+    }
+    for (auto& flow : bgFlows) {
+        flow.dataSize = dataSize;
+        flow.rate = 0.2f;
+        flow.protocol = "Net";
+        flow.path = {0, 1, 2};
+        bgFlowManager.push_back(&flow);
+    }
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < tickNum; t++) {
+        for (auto& flows : gpuFlows) {
+            communicationAoS(flows, unitTime);
+        }
+        bgStepAoS(bgFlowManager, unitTime);
+    }
+    auto end = chrono::steady_clock::now();
+    double aosTime = chrono::duration<double, nano>(end - start).count() / tickNum;
+
+    // 2. SoA
+    FlowTable flowTable;
+    vector<Flow> flows;
+    for (int g = 0; g < gpuTotal; g++) {
+        for (int i = 0; i < gpuFlowNum; i++) {
+            Flow flow(&flowTable, {g, i}, {g, i}, dataSize, i == 0 ? LINK_NVLINK : LINK_NET);
+            flow.setRate(0.1f + (g % 7) * 0.01f);
+            flow.setPath({g, g + 1, g + 2, g + 3, g + 4});
+            flows.push_back(flow);
+        }
+    }
+    for (int i = 0; i < bgFlowNum; i++) {
+        Flow flow(&flowTable, 0, 2, dataSize, LINK_NET);
+        flow.setRate(0.2f);
+        flow.setPath({0, 1, 2});
+        flows.push_back(flow);
+    }
+    start = chrono::steady_clock::now();
+    for (int t = 0; t < tickNum; t++) {
+        flowTable.drain(unitTime);
+    }
+    end = chrono::steady_clock::now();
+    double soaTime = chrono::duration<double, nano>(end - start).count() / tickNum;
+
+    // 3. 事件驱动里求最早发送完的时间
+    start = chrono::steady_clock::now();
+    float eventTime = 0;
+    for (int t = 0; t < tickNum; t++) {
+        eventTime += flowTable.nextDrainTime(unitTime);
+    }
+    end = chrono::steady_clock::now();
+    double nextDrainTime = chrono::duration<double, nano>(end - start).count() / tickNum;
+
+    cout << "flows: " << flowTable.size() << " ticks: " << tickNum << endl;
+    cout << "AoS step: " << aosTime << " ns/tick" << endl;
+    cout << "SoA drain: " << soaTime << " ns/tick" << endl;
+    cout << "speedup: " << aosTime / soaTime << "x" << endl;
+    cout << "SoA nextDrainTime: " << nextDrainTime << " ns/call (" << eventTime / tickNum << ")" << endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "flow.h"
+#include "gpu.h"
+#include "server.h"
+#include "network.h"
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+
+using namespace std;
+
+/*
+速率分配算法的性能测试
+分别在64，512，4096个gpu的网络上，测量waterFilling和maxMinFairness每次调用的耗时，
+并比较两种算法分配出去的总带宽（max-min会把瓶颈link剩余的带宽分给其他flow，总带宽更高）
+另外测量稳定状态下（没有flow开始或结束）增量分配updateRate每次调用的耗时
+
+网络设置：
+    每个server有8个gpu，每个gpu有一个NVLink flow和一个Net flow，Net flow用ECMPRandom随机选择spine
+    另外在leaf之间随机生成bgFlowNum个背景流量
+*/
+
+// 生成leaf之间的背景流量，leaf的编号范围和路径由network生成的拓扑给出
+void generateBgFlow(std::vector<Flow>& bgFlows, Network& network, int bgFlowNum, float dataSize) {
+    for (int i = 0; i < bgFlowNum; i++) {
+        RandomStream rng = network.stream(RNG_BG_FLOW_PLACE, i);
+        int srcLeafId = network.leafBase + rng.below(network.leafNum);
+        int dstLeafId = network.leafBase + rng.below(network.leafNum);
+        while (srcLeafId == dstLeafId) {
+            dstLeafId = network.leafBase + rng.below(network.leafNum);
+        }
+        Flow flow(&network.flowTable, srcLeafId, dstLeafId, dataSize, LINK_NET);
+        flow.setPath(network.ecmpPath(srcLeafId, dstLeafId, rng.below(network.ecmpPathNum(srcLeafId, dstLeafId))));
+        bgFlows.push_back(flow);
+    }
+    for (auto& flow : bgFlows) {
+        network.bgFlowManager.push_back(&flow);
+    }
+}
+
+// 测量一个速率分配算法每次调用的平均耗时，单位us
+double timeAllocator(Network& network, RateAllocator allocator, int repeat) {
+    network.rateAllocator = allocator;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        network.allocateRate();
+    }
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, micro>(end - start).count() / repeat;
+}
+
+// 测量稳定状态下updateRate每次调用的平均耗时，单位us
+double timeUpdateRate(Network& network, int repeat) {
+    network.rateAllocator = RateAllocator::WaterFilling;
+    network.allocateRate();
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        network.updateRate();
+    }
+    auto end = chrono::steady_clock::now();
+    return chrono::duration<double, micro>(end - start).count() / repeat;
+}
+
+// 所有活跃flow分配到的rate之和
+float totalRate(Network& network) {
+    float sum = 0;
+    for (auto& flow : network.gpuFlowManager) {
+        if (flow->dataSize() > 0) {
+            sum += flow->rate();
+        }
+    }
+    for (auto& flow : network.bgFlowManager) {
+        if (flow->dataSize() > 0) {
+            sum += flow->rate();
+        }
+    }
+    return sum;
+}
+
+int main() {
+    int gpuNum = 8;
+    float gpuDataSize = 1024;
+    float NVLinkBandwidth = 1.6384;
+    float topoBW = 0.4096;
+    int bgFlowNum = 64;
+    vector<int> gpuTotalList = {64, 512, 4096};
+
+    cout << "gpus\tflows\twaterFilling(us)\tmaxMin(us)\tupdateRate(us)\twaterFillingRate\tmaxMinRate" << endl;
+    for (int gpuTotal : gpuTotalList) {
+        int serverGroupNum = gpuTotal / gpuNum;
+        std::vector<std::vector<float>> NVLink(gpuNum, std::vector<float>(gpuNum, NVLinkBandwidth));
+
+        Network network;
+        network.init(serverGroupNum, gpuNum, gpuDataSize, NVLink, topoBW);
+        for (auto& server : network.serverGroup) {
+            for (auto& gpu : server.gpus) {
+                pair<int, int> src = {server.id, gpu.rank};
+                pair<int, int> dst = {server.id, server.ring[src.second]};
+
+                Flow flowNVLink(&network.flowTable);
+                flowNVLink.init(src, dst, gpuDataSize, LINK_NVLINK);
+                flowNVLink.setRate(server.NVLink[src.second][dst.second]);
+                gpu.addFlow(flowNVLink);
+
+                Flow flowNet(&network.flowTable);
+                flowNet.init(src, dst, gpuDataSize, LINK_NET);
+                gpu.addFlow(flowNet);
+                network.gpuFlowManager.push_back(&gpu.flowOf(LINK_NET));
+            }
+        }
+        network.ECMPRandom();
+
+        vector<Flow> bgFlows;
+        generateBgFlow(bgFlows, network, bgFlowNum, gpuDataSize);
+
+        // 网络越大，单次调用越慢，减少重复次数
+        int repeat = max(1, 4096 / gpuTotal) * 4;
+        double waterFillingTime = timeAllocator(network, RateAllocator::WaterFilling, repeat);
+        float waterFillingRate = totalRate(network);
+        double maxMinTime = timeAllocator(network, RateAllocator::MaxMin, repeat);
+        float maxMinRate = totalRate(network);
+        double updateRateTime = timeUpdateRate(network, repeat);
+
+        int flowNum = network.gpuFlowManager.size() + network.bgFlowManager.size();
+        cout << gpuTotal << "\t" << flowNum << "\t" << waterFillingTime << "\t" << maxMinTime << "\t" << updateRateTime << "\t"
+             << waterFillingRate << "\t" << maxMinRate << endl;
+    }
+    return 0;
+}
\ No newline at end of file
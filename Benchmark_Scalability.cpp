@@ -0,0 +1,318 @@
+#include "simulation.h"
+#include "collective.h"
+#include "rng.h"
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <utility>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/*
+模拟主循环的可扩展性测试
+对server数量，背景流量数量，gpuDataSize和每个tick的线程数量的网格里的每个点，分别测量以下组件每次调用（一个tick）的耗时：
+    waterFilling：Network::waterFilling，全量重新分配rate
+    step：Network::step，所有flow发送一个unitTime的数据
+    control：Network::control，所有server的滑动窗口决策和增量updateRate
+    computing：所有server的Server::computing
+    dijkstra：Network::dijkstra，随机gpu对之间的最短路径
+    loop：完整的事件驱动循环（nextEventTime，step，control，progress），与runSimulation相同
+
+用法：
+    Benchmark_Scalability [format=tsv|json] [minTime=ms] [servers=8,64,...] [bgFlows=10,1000,...] [dataSize=1024,...] [tickThreads=1,2,...]
+    每个组件至少运行minTime毫秒（默认100）和3个tick
+    内存为最大常驻内存（peak RSS）：每个组件在fork出的子进程里创建网络并运行，子进程的峰值只包含这一个点和这一个组件，
+    不受之前的点释放后留在堆里的内存影响；setupPeakRSS为创建网络之后的峰值，peakRSS为组件运行之后的峰值，
+    componentPeakDelta为两者之差，即组件运行期间峰值的增长；两个峰值都包含进程本身的基础内存（几MB）
+    Windows上没有fork，在同一个进程里运行，峰值是进程到目前为止的最大值，会包含之前的点
+
+输出：
+    tsv：每行一个(点, 组件)，列为servers，gpus，bgFlows，dataSize，tickThreads，component，ticks，ns/tick，ticks/s，
+         setupPeakRSS(KB)，peakRSS(KB)，componentPeakDelta(KB)
+    json：每行一个json对象，字段名与tsv的列名相同，便于脚本比较不同版本的结果
+    loop在第一个tick之前集合通信就已经完成时ticks为0，ns/tick和ticks/s没有意义，tsv里为-，json里为null；子进程异常退出时同样处理，内存为0
+
+网络设置：
+    每个server有8个gpu，leaf/spine拓扑，server滑动窗口的ring AllReduce，背景流量随机分布在leaf之间
+*/
+
+// 一个测试点的网络，Network里的flow通过指针互相引用，不能移动，所以整体放在堆上
+struct Bench {
+    Network network;
+    vector<Flow> bgFlows;
+    RingAllReduce collective;
+};
+
+// 一个组件的测量结果，ticks为0时没有运行
+struct ComponentResult {
+    long long ticks = 0;
+    double elapsed = 0;    // 总耗时，单位ns
+    long setupPeakRSS = 0; // 创建网络之后的峰值，单位KB
+    long peakRSS = 0;      // 组件运行之后的峰值，单位KB
+};
+
+// 进程的最大常驻内存，单位KB
+long peakRSS() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#endif
+}
+
+// 与runSimulation相同的初始化：gpu的NVLink和Net flow，固定路由，随机背景流量，开始第一个step并分配rate
+unique_ptr<Bench> setup(const SimConfig& config) {
+    auto bench = make_unique<Bench>();
+    Network& network = bench->network;
+    vector<vector<float>> NVLink(config.gpuNum, vector<float>(config.gpuNum, config.NVLinkBandwidth));
+    network.seed(config.seed);
+    network.init(config.serverGroupNum, config.gpuNum, config.gpuDataSize, NVLink, config.topoBW);
+    network.setTickThreads(config.tickThreads);
+    for (auto& server : network.serverGroup) {
+        for (auto& gpu : server.gpus) {
+            pair<int, int> src = {server.id, gpu.rank};
+            pair<int, int> dst = {server.id, server.ring[src.second]};
+
+            Flow flowNVLink(&network.flowTable);
+            flowNVLink.init(src, dst, 0, LINK_NVLINK);
+            flowNVLink.setRate(server.NVLink[src.second][dst.second]);
+            gpu.addFlow(flowNVLink);
+
+            Flow flowNet(&network.flowTable);
+            flowNet.init(src, dst, 0, LINK_NET);
+            gpu.addFlow(flowNet);
+            network.gpuFlowManager.push_back(&gpu.flowOf(LINK_NET));
+        }
+    }
+    network.Routing();
+
+    // 背景流量一开始就有数据，测试期间一直处于发送状态
+    generateBgFlowRandom(bench->bgFlows, network, config.bgFlowNum, config.bgFlowRoutingNum);
+    for (auto& flow : bench->bgFlows) {
+        flow.dataSize() = config.gpuDataSize;
+    }
+    bench->collective.init(&network, config, 2 * (config.gpuNum - 1));
+    bench->collective.start();
+    network.allocateRate();
+    return bench;
+}
+
+// 重复调用tick直到超过minTime毫秒并且至少3次，tick返回false时提前结束，返回tick的次数和总耗时（ns）
+pair<long long, double> measure(const function<bool()>& tick, double minTime) {
+    long long ticks = 0;
+    auto start = chrono::steady_clock::now();
+    double elapsed = 0;
+    while (ticks < 3 || elapsed < minTime * 1e6) {
+        if (!tick()) {
+            break;
+        }
+        ticks++;
+        elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    }
+    return {ticks, elapsed};
+}
+
+/*
+目标：
+    在一个新的网络上运行一个组件，峰值内存只包含这个点和这个组件
+思路：
+    1. 子进程里创建网络，依次记录创建之后和组件运行之后的峰值，结果通过pipe写回父进程
+    2. 父进程不创建网络，fork出的子进程的峰值从很小的值开始；fork之前先flush输出，子进程用_exit退出，不会重复输出
+    3. 子进程异常退出或者没有fork时，返回空的结果；Windows上直接在当前进程里运行
+*/
+ComponentResult runComponent(const SimConfig& config, const function<pair<long long, double>(Bench&)>& component) {
+    auto run = [&] {
+        ComponentResult result;
+        auto bench = setup(config);
+        result.setupPeakRSS = peakRSS();
+        auto measured = component(*bench);
+        result.peakRSS = peakRSS();
+        result.ticks = measured.first;
+        result.elapsed = measured.second;
+        return result;
+    };
+#ifdef _WIN32
+    return run();
+#else
+    // 1. 2. 子进程运行组件
+    cout.flush();
+    int fd[2];
+    if (pipe(fd) != 0) {
+        return ComponentResult();
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fd[0]);
+        ComponentResult result = run();
+        bool written = write(fd[1], &result, sizeof(result)) == (ssize_t)sizeof(result);
+        _exit(written ? 0 : 1);
+    }
+    close(fd[1]);
+
+    // 3. 读回结果
+    ComponentResult result;
+    if (pid < 0 || read(fd[0], &result, sizeof(result)) != (ssize_t)sizeof(result)) {
+        result = ComponentResult();
+    }
+    close(fd[0]);
+    if (pid > 0) {
+        waitpid(pid, nullptr, 0);
+    }
+    return result;
+#endif
+}
+
+// 解析 v1,v2,... 形式的整数列表
+vector<int> parseList(const string& value) {
+    vector<int> list;
+    size_t begin = 0;
+    while (true) {
+        size_t comma = value.find(',', begin);
+        list.push_back(stoi(value.substr(begin, comma - begin)));
+        if (comma == string::npos) {
+            break;
+        }
+        begin = comma + 1;
+    }
+    return list;
+}
+
+int main(int argc, char* argv[]) {
+    // 1. 解析参数
+    string format = "tsv";
+    double minTime = 100;
+    vector<int> serverList = {8, 64, 512, 1024};
+    vector<int> bgFlowList = {10, 1000, 100000};
+    vector<int> dataSizeList = {1024, 8192};
+    vector<int> tickThreadList = {1};
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        string name = arg.substr(0, eq);
+        string value = eq == string::npos ? "" : arg.substr(eq + 1);
+        if (name == "format" && (value == "tsv" || value == "json")) format = value;
+        else if (name == "minTime") minTime = stod(value);
+        else if (name == "servers") serverList = parseList(value);
+        else if (name == "bgFlows") bgFlowList = parseList(value);
+        else if (name == "dataSize") dataSizeList = parseList(value);
+        else if (name == "tickThreads") tickThreadList = parseList(value);
+        else {
+            cerr << "usage: Benchmark_Scalability [format=tsv|json] [minTime=ms] [servers=...] [bgFlows=...] [dataSize=...] [tickThreads=...]" << endl;
+            return 1;
+        }
+    }
+
+    if (format == "tsv") {
+        cout << "servers\tgpus\tbgFlows\tdataSize\ttickThreads\tcomponent\tticks\tns/tick\tticks/s\tsetupPeakRSS(KB)\tpeakRSS(KB)\tcomponentPeakDelta(KB)" << endl;
+    }
+    for (int serverGroupNum : serverList) {
+        for (int bgFlowNum : bgFlowList) {
+            for (int dataSize : dataSizeList) {
+                for (int tickThreads : tickThreadList) {
+                    SimConfig config;
+                    config.tickThreads = tickThreads;
+                    config.serverGroupNum = serverGroupNum;
+                    config.gpuDataSize = dataSize;
+                    config.collective = Collective::AllReduce;
+                    config.mode = SplitMode::ServerWindow;
+                    config.bgFlowNum = bgFlowNum;
+
+                    // 2. 每个组件在一个新的网络上测量，step和loop会改变flow的状态，不影响其他组件
+                    vector<pair<string, function<pair<long long, double>(Bench&)>>> components = {
+                        {"waterFilling", [&](Bench& bench) {
+                            return measure([&] { bench.network.waterFilling(); return true; }, minTime);
+                        }},
+                        {"step", [&](Bench& bench) {
+                            return measure([&] { bench.network.step(config.unitTime); return true; }, minTime);
+                        }},
+                        {"control", [&](Bench& bench) {
+                            return measure([&] { bench.network.control(config.unitTime); return true; }, minTime);
+                        }},
+                        {"computing", [&](Bench& bench) {
+                            return measure([&] {
+                                for (auto& server : bench.network.serverGroup) {
+                                    server.computing(config.unitTime);
+                                }
+                                return true;
+                            }, minTime);
+                        }},
+                        {"dijkstra", [&](Bench& bench) {
+                            RandomStream rng(config.seed, 0);
+                            int gpuTotal = bench.network.gpuTotal;
+                            return measure([&] {
+                                int src = rng.below(gpuTotal);
+                                int dst = (src + 1 + rng.below(gpuTotal - 1)) % gpuTotal;
+                                bench.network.dijkstra(src, dst);
+                                return true;
+                            }, minTime);
+                        }},
+                        // 集合通信完成时提前结束
+                        {"loop", [&](Bench& bench) {
+                            float time = 0;
+                            return measure([&] {
+                                if (bench.collective.finished()) {
+                                    return false;
+                                }
+                                float dt = bench.network.nextEventTime(config.unitTime);
+                                time += dt;
+                                bench.network.step(dt);
+                                bench.network.control(dt);
+                                if (bench.collective.progress(time)) {
+                                    bench.network.updateRate();
+                                }
+                                return true;
+                            }, minTime);
+                        }},
+                    };
+
+                    // 3. 输出结果，每个组件在自己的子进程里测量峰值内存；没有tick时不计算每个tick的耗时
+                    for (auto& component : components) {
+                        ComponentResult result = runComponent(config, component.second);
+
+                        string nsPerTick = format == "tsv" ? "-" : "null";
+                        string ticksPerSecond = nsPerTick;
+                        if (result.ticks > 0) {
+                            ostringstream perTick, perSecond;
+                            perTick << result.elapsed / result.ticks;
+                            perSecond << 1e9 * result.ticks / result.elapsed;
+                            nsPerTick = perTick.str();
+                            ticksPerSecond = perSecond.str();
+                        }
+                        long componentPeakDelta = result.peakRSS - result.setupPeakRSS;
+                        int gpus = serverGroupNum * config.gpuNum;
+                        if (format == "tsv") {
+                            cout << serverGroupNum << "\t" << gpus << "\t" << bgFlowNum << "\t" << dataSize << "\t" << tickThreads << "\t"
+                                 << component.first << "\t" << result.ticks << "\t" << nsPerTick << "\t" << ticksPerSecond << "\t"
+                                 << result.setupPeakRSS << "\t" << result.peakRSS << "\t" << componentPeakDelta << endl;
+                        }
+                        else {
+                            cout << "{\"servers\": " << serverGroupNum << ", \"gpus\": " << gpus << ", \"bgFlows\": " << bgFlowNum
+                                 << ", \"dataSize\": " << dataSize << ", \"tickThreads\": " << tickThreads
+                                 << ", \"component\": \"" << component.first
+                                 << "\", \"ticks\": " << result.ticks << ", \"ns/tick\": " << nsPerTick
+                                 << ", \"ticks/s\": " << ticksPerSecond << ", \"setupPeakRSS(KB)\": " << result.setupPeakRSS
+                                 << ", \"peakRSS(KB)\": " << result.peakRSS << ", \"componentPeakDelta(KB)\": " << componentPeakDelta << "}" << endl;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "simulation.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+场景驱动的模拟器，拓扑大小，带宽，集合通信类型，NVLink/Net的分配方式和背景流量都由场景文件给出，不需要重新编译
+
+用法：
+    Simulator [threads=N] scenario... [name=value ...]
+    scenario是场景文件，格式见scenarios/目录，可以给出多个，在线程池里并行运行，按给出的顺序输出
+    name=value会覆盖所有场景文件里的同名参数，例如 Simulator scenarios/allreduce_window_server.txt seed=2
+
+checkpoint（见checkpoint.h）：
+    Simulator scenario.txt checkpointFile=a.ckpt checkpointTime=5000  在time = 5000时保存全部状态
+    Simulator scenario.txt restoreFile=a.ckpt alpha=0.1               从time = 5000继续，alpha不同的what-if
+
+多个作业共享网络（见scenarios/Job_Mix.txt）：
+    Simulator scenarios/Job_Mix.txt "job=extra collective=allToAll servers=0-1 iterations=2"  job不覆盖而是再增加一个作业
+    输出每个作业每次迭代的时间和平均迭代时间
+
+参数换算关系：
+    unitTime = 0.001ms = 1μs = 1微秒
+    NVLink: 200 GB/s = 204.8 MB/ms = 1638.4 Mb/ms = 1.6384 Mb/μs
+    Net: 400 Gb/S = 409.6 Mb/ms = 0.4096 Mb/μs
+    128MB = 1024Mb, 1G = 1024MB = 8192Mb
+*/
+
+int main(int argc, char* argv[]) {
+    // 1. 区分场景文件和覆盖的参数
+    int threadNum = 0;
+    vector<string> scenarios;
+    vector<pair<string, string>> overrides;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (eq == string::npos) {
+            scenarios.push_back(arg);
+        }
+        else if (arg.substr(0, eq) == "threads") {
+            threadNum = stoi(arg.substr(eq + 1));
+        }
+        else {
+            overrides.push_back({arg.substr(0, eq), arg.substr(eq + 1)});
+        }
+    }
+    if (scenarios.empty()) {
+        cerr << "usage: Simulator [threads=N] scenario... [name=value ...]" << endl;
+        return 1;
+    }
+
+    // 2. 启动时读取所有场景文件
+    vector<SimConfig> configs(scenarios.size());
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        configs[i].name = scenarios[i];
+        if (!loadScenario(scenarios[i], configs[i])) {
+            return 1;
+        }
+        for (auto& param : overrides) {
+            if (!setParam(configs[i], param.first, param.second)) {
+                cerr << "invalid parameter: " << param.first << "=" << param.second << endl;
+                return 1;
+            }
+        }
+    }
+
+    // 3. 每个场景一个独立的Network，输出先写到自己的缓冲里
+    vector<SimResult> results(configs.size());
+    vector<ostringstream> logs(configs.size());
+    {
+        ThreadPool pool(threadNum);
+        for (size_t i = 0; i < configs.size(); i++) {
+            pool.submit([&configs, &results, &logs, i] {
+                results[i] = runSimulation(configs[i], &logs[i]);
+            });
+        }
+        pool.wait();
+    }
+
+    // 4. 按给出的顺序输出
+    for (size_t i = 0; i < configs.size(); i++) {
+        cout << "------------------------------------------" << endl;
+        cout << "scenario: " << configs[i].name << endl;
+        cout << logs[i].str();
+        if (!results[i].error.empty()) {
+            cout << "error: " << results[i].error << endl;
+        }
+        cout << "maxTime: " << results[i].maxTime << endl;
+        cout << "Total time: " << results[i].time << endl;
+        cout << "Simulation finished!" << endl;
+        cout << "------------------------------------------" << endl;
+    }
+    return 0;
+}
\ No newline at end of file
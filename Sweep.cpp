@@ -0,0 +1,153 @@
+#include "simulation.h"
+#include "thread_pool.h"
+#include "rng.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+/*
+参数扫描：对参数网格里的每个点运行一次独立的模拟，所有点在线程池里并行运行，结果输出为一张表
+
+用法：
+    Sweep [threads=N] [replicas=N] [scenario=file] name=v1,v2,... name=v1,v2,...
+    name是SimConfig的成员名，例如 Cnvl=1.6384,16.384 Cnet=0.2048,0.4096 mode=serverWindow seed=1,2,3
+    多个参数的取值做笛卡尔积，没有给出的参数取场景文件里的值，没有场景文件时取SimConfig的默认值
+    threads为线程数，默认使用硬件线程数
+    replicas为每个参数点重复运行的次数，第k次的种子由该点的seed和k派生，不同重复之间的随机数互相独立
+    每个点的结果只由它的参数决定，与线程数和运行顺序无关
+    没有参数时运行一个默认的网格：server滑动窗口，比较不同的Cnvl，Cnet和随机数种子；场景里有作业时只能比较不同的ratio和随机数种子
+
+输出：
+    每行一个参数点，前几列是扫描的参数（有replicas时还有replica和replicaSeed），后面是time，maxTime，steps，wallTime(ms)，以tab分隔
+*/
+
+int main(int argc, char* argv[]) {
+    // 1. 解析参数网格
+    int threadNum = 0;
+    int replicaNum = 0;
+    SimConfig base;
+    vector<pair<string, vector<string>>> grid;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (eq == string::npos) {
+            cerr << "invalid argument: " << arg << endl;
+            return 1;
+        }
+        string name = arg.substr(0, eq);
+        if (name == "threads") {
+            threadNum = stoi(arg.substr(eq + 1));
+            continue;
+        }
+        if (name == "replicas") {
+            replicaNum = stoi(arg.substr(eq + 1));
+            continue;
+        }
+        if (name == "scenario") {
+            if (!loadScenario(arg.substr(eq + 1), base)) {
+                return 1;
+            }
+            continue;
+        }
+        vector<string> values;
+        size_t begin = eq + 1;
+        while (true) {
+            size_t comma = arg.find(',', begin);
+            values.push_back(arg.substr(begin, comma - begin));
+            if (comma == string::npos) {
+                break;
+            }
+            begin = comma + 1;
+        }
+        grid.push_back({name, values});
+    }
+    if (grid.empty() && !base.jobs.empty()) {
+        grid = {
+            {"ratio", {"0.6", "0.8", "1"}},
+            {"seed", {"1", "2", "3"}},
+        };
+    }
+    else if (grid.empty()) {
+        grid = {
+            {"collective", {"allReduce"}},
+            {"mode", {"serverWindow"}},
+            {"Cnvl", {"1.6384", "16.384", "114.688"}},
+            {"Cnet", {"0.2048", "0.4096"}},
+            {"seed", {"1", "2", "3"}},
+        };
+    }
+
+    // 2. 参数网格的笛卡尔积，每个点一个SimConfig
+    vector<SimConfig> configs(1, base);
+    for (auto& param : grid) {
+        vector<SimConfig> next;
+        for (auto& config : configs) {
+            for (auto& value : param.second) {
+                SimConfig point = config;
+                if (!setParam(point, param.first, value)) {
+                    cerr << "invalid parameter: " << param.first << "=" << value << endl;
+                    return 1;
+                }
+                next.push_back(point);
+            }
+        }
+        configs = next;
+    }
+
+    // 每个点重复replicaNum次，第k次的种子取该点主种子下RNG_REPLICA的第k个stream，输出时仍然给出网格里的参数
+    vector<SimConfig> points = configs;
+    vector<int> pointOf(configs.size());
+    vector<int> replicas(configs.size(), 0);
+    for (size_t i = 0; i < configs.size(); i++) {
+        pointOf[i] = i;
+    }
+    if (replicaNum > 0) {
+        configs.clear();
+        pointOf.clear();
+        replicas.clear();
+        for (size_t i = 0; i < points.size(); i++) {
+            for (int k = 0; k < replicaNum; k++) {
+                SimConfig config = points[i];
+                config.seed = replicaSeed(points[i].seed, k);
+                configs.push_back(config);
+                pointOf.push_back(i);
+                replicas.push_back(k);
+            }
+        }
+    }
+
+    // 3. 每个点在线程池里运行一个独立的Network，结果写到自己的位置，不需要加锁
+    vector<SimResult> results(configs.size());
+    {
+        ThreadPool pool(threadNum);
+        for (size_t i = 0; i < configs.size(); i++) {
+            pool.submit([&configs, &results, i] {
+                results[i] = runSimulation(configs[i]);
+            });
+        }
+        pool.wait();
+    }
+
+    // 4. 按网格的顺序输出结果
+    for (auto& param : grid) {
+        cout << param.first << "\t";
+    }
+    if (replicaNum > 0) {
+        cout << "replica\treplicaSeed\t";
+    }
+    cout << "time\tmaxTime\tsteps\twallTime(ms)" << endl;
+    for (size_t i = 0; i < configs.size(); i++) {
+        for (auto& param : grid) {
+            cout << getParam(points[pointOf[i]], param.first) << "\t";
+        }
+        if (replicaNum > 0) {
+            cout << replicas[i] << "\t" << configs[i].seed << "\t";
+        }
+        cout << results[i].time << "\t" << results[i].maxTime << "\t"
+             << results[i].steps << "\t" << results[i].wallTime << endl;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "trace.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+/*
+把文本格式的背景流量trace转换成Simulator回放使用的二进制格式（见trace.h）
+
+用法：
+    TraceConvert input.txt output.bin
+    input每行一条记录：time src dst bytes，#后面是注释，time必须从小到大排列
+    逐行转换，不需要把trace读到内存里；有不合法的行时在std::cerr里给出行号并返回1
+
+回放：
+    Simulator scenario.txt bgFlowModel=trace bgFlowTrace=output.bin
+*/
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        cerr << "usage: TraceConvert input.txt output.bin" << endl;
+        return 1;
+    }
+    ifstream in(argv[1]);
+    if (!in) {
+        cerr << "cannot open " << argv[1] << endl;
+        return 1;
+    }
+    ofstream out(argv[2], ios::binary);
+    if (!out) {
+        cerr << "cannot open " << argv[2] << endl;
+        return 1;
+    }
+
+    // 1. 文件头，recordNum在最后写入
+    uint32_t version = 1;
+    uint64_t recordNum = 0;
+    out.write("BGTR", 4);
+    out.write((const char*)&version, sizeof(version));
+    out.write((const char*)&recordNum, sizeof(recordNum));
+
+    // 2. 逐行转换
+    string line;
+    int lineNum = 0;
+    double lastTime = 0;
+    while (getline(in, line)) {
+        lineNum++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) {
+            line = line.substr(0, comment);
+        }
+        istringstream fields(line);
+        TraceRecord record;
+        if (!(fields >> record.time)) {
+            continue;
+        }
+        if (!(fields >> record.src >> record.dst >> record.bytes) || !(fields >> ws).eof() || record.time < lastTime) {
+            cerr << argv[1] << ":" << lineNum << ": invalid record: " << line << endl;
+            return 1;
+        }
+        lastTime = record.time;
+        out.write((const char*)&record, sizeof(record));
+        recordNum++;
+    }
+
+    // 3. 写入recordNum
+    out.seekp(8);
+    out.write((const char*)&recordNum, sizeof(recordNum));
+    cout << recordNum << " records" << endl;
+    return 0;
+}
\ No newline at end of file
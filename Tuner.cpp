@@ -0,0 +1,83 @@
+#include "simulation.h"
+#include "tuner.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*
+NVLink/Net分配方式和滑动窗口参数的自动调优，见tuner.h
+
+用法：
+    Tuner [threads=N] [replicas=N] [evaluations=N] [verify=N] [short=0|1] [scenario] [name=value ...]
+    scenario是场景文件，name=value覆盖场景文件里的参数，例如 Tuner scenarios/AllReduce_Brust_Flow_Window_Server.txt gpuDataSize=2048 bgFlowLoad=0.3
+    调优的对象由mode决定：ratio时调优ratio，gpuWindow/serverWindow时调优Cnvl，Cnet，Wnvl，Wnet，alpha，delta；层次化和树形的AllReduce，all-to-all以及作业只调优ratio
+    threads为线程数，默认使用硬件线程数；replicas为每个点取平均的种子数量，默认为1（只用场景的seed）
+    evaluations为搜索阶段最多的点数；verify为用完整的config验证的候选点数量
+    short=1（默认）时allReduce的搜索阶段只模拟第一个ring step，short=0时搜索阶段也模拟完整的allReduce
+
+输出：
+    #开头的行为每一轮搜索的进度，解析模型的估计，原来的config，解析起点和调优结果的完成时间
+    最后是调优结果的参数，每行一个 name = value，可以直接加到场景文件里
+*/
+
+int main(int argc, char* argv[]) {
+    // 1. 解析参数
+    TuneOptions options;
+    SimConfig config;
+    vector<pair<string, string>> overrides;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (eq == string::npos) {
+            if (!loadScenario(arg, config)) {
+                return 1;
+            }
+            continue;
+        }
+        string name = arg.substr(0, eq);
+        string value = arg.substr(eq + 1);
+        if (name == "threads") {
+            options.threadNum = stoi(value);
+        }
+        else if (name == "replicas") {
+            options.replicas = stoi(value);
+        }
+        else if (name == "evaluations") {
+            options.maxEvaluations = stoi(value);
+        }
+        else if (name == "verify") {
+            options.verifyNum = stoi(value);
+        }
+        else if (name == "short") {
+            options.shortRuns = value != "0";
+        }
+        else {
+            overrides.push_back({name, value});
+        }
+    }
+    for (auto& item : overrides) {
+        if (!setParam(config, item.first, item.second)) {
+            cerr << "invalid parameter: " << item.first << "=" << item.second << endl;
+            return 1;
+        }
+    }
+
+    // 2. 调优
+    TuneResult result = tuneConfig(config, options, &cout);
+
+    // 3. 解析模型的估计，完成时间和调优结果的参数
+    SplitEstimate& estimate = result.estimate;
+    cout << "# analytical model: NVLink = " << estimate.nvlinkBW << " Net = " << estimate.netBW << " bgLoad = " << estimate.bgLoad
+         << " ratio = " << estimate.ratio << " stepTime = " << estimate.stepTime << " chunkTime = " << estimate.chunkTime << endl;
+    cout << "# baseline time: " << result.baselineTime << endl;
+    cout << "# analytical time: " << result.analyticalTime << endl;
+    cout << "# tuned time: " << result.bestTime << " (iterations = " << result.iterations
+         << ", simulations = " << result.evaluations << ")" << endl;
+    cout << "mode = " << getParam(result.best, "mode") << endl;
+    for (auto& param : tuneParams(result.best, result.estimate)) {
+        cout << param.name << " = " << getParam(result.best, param.name) << endl;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,445 @@
+#include "checkpoint.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace {
+
+// 结构参数：决定拓扑，路由和flow的数量，恢复时必须与checkpoint相同
+const char* const structuralParams[] = {
+    "serverGroupNum", "gpuNum", "gpuDataSize", "NVLinkBandwidth", "topoBW", "topology", "radix", "oversubscription",
+    "collective", "mode", "bgFlowModel", "bgFlow", "bgFlowNum", "bgFlowRoutingNum", "bgFlowTrace", "seed",
+    "congestionControl", "routing", "treeChunks", "allToAllPeers", "job"};
+
+// 背景流量到达过程的参数，与checkpoint不同时从恢复的时刻重新安排到达事件
+const char* const trafficParams[] = {
+    "bgFlowPeriod", "bgFlowDataSizeRatio", "bgFlowArrival", "bgFlowSizeDist", "bgFlowSize", "bgFlowSizeShape",
+    "bgFlowLoad", "bgFlowOnTime", "bgFlowOffTime"};
+
+// 其他保存在checkpoint里的参数，恢复时可以不同
+const char* const policyParams[] = {
+    "rateAllocator", "alpha", "delta", "ratio", "len", "Cnvl", "Cnet", "Wnvl", "Wnet", "unitTime",
+    "rerouteInterval", "migrationCost", "ccPeriod", "ccBaseRtt", "dcqcnKmin", "dcqcnKmax", "dcqcnPmax", "dcqcnRai", "windowTargetDelay", "windowAi",
+    "transferLatency"};
+
+// 写checkpoint，数值按内存里的表示直接写入
+class CheckpointWriter {
+public:
+    static constexpr bool loading = false;
+    std::ofstream out;
+    bool ok = true;
+
+    template <class T>
+    void value(const T& v) {
+        out.write((const char*)&v, sizeof(T));
+    }
+
+    template <class T>
+    void array(const std::vector<T>& v) {
+        uint64_t size = v.size();
+        value(size);
+        out.write((const char*)v.data(), size * sizeof(T));
+    }
+
+    // 长度由setup决定的数组，写入时与array相同
+    template <class T>
+    void fixed(const std::vector<T>& v) {
+        array(v);
+    }
+
+    void text(const std::string& s) {
+        uint64_t size = s.size();
+        value(size);
+        out.write(s.data(), size);
+    }
+};
+
+// 读checkpoint，任何一次读取失败或长度不一致之后ok为false，之后的读取都不再改变状态
+class CheckpointReader {
+public:
+    static constexpr bool loading = true;
+    std::ifstream in;
+    uint64_t fileSize = 0;
+    bool ok = true;
+
+    template <class T>
+    void value(T& v) {
+        char read[sizeof(T)];
+        if (ok && in.read(read, sizeof(T))) {
+            std::memcpy((void*)&v, read, sizeof(T));
+        }
+        else {
+            ok = false;
+        }
+    }
+
+    // 长度超过文件剩余的大小时认为文件已经损坏，不分配内存
+    template <class T>
+    void array(std::vector<T>& v) {
+        uint64_t size = 0;
+        value(size);
+        if (!ok || size > fileSize / sizeof(T)) {
+            ok = false;
+            return;
+        }
+        v.resize(size);
+        if (!in.read((char*)v.data(), size * sizeof(T))) {
+            ok = false;
+        }
+    }
+
+    template <class T>
+    void fixed(std::vector<T>& v) {
+        uint64_t size = 0;
+        value(size);
+        if (!ok || size != v.size() || !in.read((char*)v.data(), size * sizeof(T))) {
+            ok = false;
+        }
+    }
+
+    void text(std::string& s) {
+        std::vector<char> chars;
+        array(chars);
+        s.assign(chars.begin(), chars.end());
+    }
+};
+
+// flow在FlowTable以外的动态字段，路径可能在模拟中改变，links和active与link的流数量一致
+template <class Archive>
+void transferFlow(Archive& ar, Flow& flow) {
+    ar.value(flow.srcId);
+    ar.value(flow.dstId);
+    ar.value(flow.linkClass);
+    ar.array(flow.path);
+    ar.array(flow.links);
+    ar.value(flow.active);
+}
+
+// server和gpu的滑动窗口
+template <class Archive, class Node>
+void transferWindow(Archive& ar, Node& node) {
+    ar.value(node.leftClass);
+    ar.value(node.rightClass);
+    ar.value(node.chunk);
+    ar.value(node.window);
+    ar.value(node.len);
+    ar.value(node.left);
+    ar.value(node.right);
+    ar.value(node.timeChunkZero);
+    ar.value(node.timeChunkNow);
+    ar.value(node.timeChunkLast);
+    ar.value(node.alpha);
+    ar.value(node.delta);
+}
+
+/*
+目标：
+    按固定的顺序保存或恢复session的动态状态，保存和恢复使用同一个函数，顺序不会不一致
+思路：
+    1. FlowTable，所有flow的path，link的流数量整块保存
+    2. 事件堆按时间顺序保存，恢复时重新加入堆；同一时刻的事件属于不同的flow，处理顺序不影响结果
+*/
+template <class Archive>
+void transferState(Archive& ar, SimSession& session) {
+    Network& network = session.network;
+    ar.value(session.time);
+    ar.value(session.steps);
+    ar.value(session.nextReroute);
+    ar.value(session.migrations);
+
+    // trace回放，flow的数量在参数表之后，恢复时已经补齐
+    if (session.replay) {
+        TraceReplay& replay = *session.replay;
+        ar.value(replay.file.cursor);
+        ar.fixed(replay.state);
+        ar.array(replay.live);
+        ar.array(replay.freeSlots);
+        ar.value(replay.replayed);
+        ar.value(replay.skipped);
+        for (auto& flow : replay.flows) {
+            transferFlow(ar, flow);
+        }
+    }
+
+    // 1. 所有flow和link
+    FlowTable& table = network.flowTable;
+    ar.fixed(table.dataSize);
+    ar.fixed(table.rate);
+    ar.fixed(table.sentDataSize);
+    ar.fixed(table.completionTime);
+    ar.fixed(table.chunkDataSize);
+    for (auto& flow : session.bgFlows) {
+        transferFlow(ar, flow);
+    }
+    ar.fixed(network.linkFlowNum);
+    ar.fixed(network.linkDirty);
+    ar.array(network.dirtyLinks);
+    ar.array(network.stallTime);
+    ar.value(network.stalledNum);
+    if (network.congestion) {
+        CongestionControl& cc = *network.congestion;
+        ar.fixed(cc.queue);
+        ar.fixed(cc.arrival);
+        ar.array(cc.started);
+        ar.array(cc.lineRate);
+        ar.array(cc.sendRate);
+        ar.array(cc.targetRate);
+        ar.array(cc.alpha);
+        ar.array(cc.quietPeriods);
+        ar.array(cc.window);
+        ar.array(cc.rng);
+        ar.value(cc.elapsed);
+    }
+
+    for (auto& server : network.serverGroup) {
+        transferWindow(ar, server);
+        for (auto& gpu : server.gpus) {
+            ar.value(gpu.dataSize);
+            ar.value(gpu.isFinished);
+            transferWindow(ar, gpu);
+            for (auto& flow : gpu.flows) {
+                transferFlow(ar, flow);
+            }
+        }
+    }
+
+    // 集合通信的进度
+    RingAllReduce& collective = session.collective;
+    for (size_t s = 0; s < collective.completed.size(); s++) {
+        ar.fixed(collective.completed[s]);
+        ar.fixed(collective.running[s]);
+        ar.fixed(collective.windowReset[s]);
+        ar.fixed(collective.startCompletion[s]);
+        ar.fixed(collective.startSent[s]);
+    }
+    ar.fixed(collective.stepFinishTime);
+    if (session.schedule) {
+        ScheduleCollective& schedule = *session.schedule;
+        ar.fixed(schedule.opWaiting);
+        ar.fixed(schedule.opPartsLeft);
+        ar.value(schedule.doneOps);
+        std::vector<ScheduleCollective::Pending> pending;
+        if (!Archive::loading) {
+            auto heap = schedule.pending;
+            while (!heap.empty()) {
+                pending.push_back(heap.top());
+                heap.pop();
+            }
+        }
+        ar.array(pending);
+        ar.fixed(schedule.partStart);
+        for (auto& queue : schedule.channelQueue) {
+            ar.array(queue);
+        }
+        ar.fixed(schedule.channelHead);
+        ar.fixed(schedule.channelPart);
+        ar.fixed(schedule.stepFinishTime);
+        ar.fixed(schedule.iterationFinishTime);
+        for (auto& flow : schedule.flows) {
+            transferFlow(ar, flow);
+        }
+        // 队列里的part编号和pending里的传输编号在恢复之后直接用作下标
+        int partNum = schedule.partOp.size();
+        if (Archive::loading && ar.ok) {
+            schedule.pending = decltype(schedule.pending)();
+            for (auto& item : pending) {
+                ar.ok = ar.ok && item.op >= 0 && item.op < (int)schedule.opNext.size();
+                schedule.pending.push(item);
+            }
+        }
+        for (size_t c = 0; Archive::loading && ar.ok && c < schedule.flows.size(); c++) {
+            std::vector<int>& queue = schedule.channelQueue[c];
+            bool valid = schedule.channelHead[c] >= 0 && schedule.channelHead[c] <= (int)queue.size() &&
+                         schedule.channelPart[c] >= -1 && schedule.channelPart[c] < partNum;
+            for (int p : queue) {
+                valid = valid && p >= 0 && p < partNum;
+            }
+            ar.ok = valid;
+        }
+    }
+
+    // 2. 背景流量
+    BgTraffic& traffic = session.traffic;
+    ar.fixed(traffic.rng);
+    ar.fixed(traffic.interval);
+    ar.fixed(traffic.on);
+    ar.fixed(traffic.onEnd);
+    ar.fixed(traffic.periods);
+    std::vector<BgTraffic::Event> events;
+    if (!Archive::loading) {
+        auto heap = traffic.events;
+        while (!heap.empty()) {
+            events.push_back(heap.top());
+            heap.pop();
+        }
+    }
+    ar.array(events);
+    if (Archive::loading && ar.ok) {
+        traffic.events = decltype(traffic.events)();
+        for (auto& event : events) {
+            if (event.flow < 0 || event.flow >= (int)session.bgFlows.size()) {
+                ar.ok = false;
+                return;
+            }
+            traffic.events.push(event);
+        }
+    }
+    ar.fixed(session.bgFlowArrival);
+
+    // FCT统计
+    for (auto& sketch : session.fctStats.sketches) {
+        ar.array(sketch.buckets);
+        ar.value(sketch.count);
+        ar.value(sketch.min);
+        ar.value(sketch.max);
+        ar.value(sketch.sum);
+    }
+}
+
+} // namespace
+
+/*
+目标：
+    保存session的全部状态
+思路：
+    先写所有结构参数，背景流量和其他策略参数的值，恢复时用来检查和判断哪些参数改变了
+    再写trace回放的flow数量（没有回放时为-1），最后写动态状态
+*/
+bool saveCheckpoint(const std::string& path, SimSession& session) {
+    CheckpointWriter writer;
+    writer.out.open(path, std::ios::binary);
+    if (!writer.out) {
+        return false;
+    }
+    uint32_t version = 9;
+    writer.out.write("SIMC", 4);
+    writer.value(version);
+
+    std::vector<std::string> names(std::begin(structuralParams), std::end(structuralParams));
+    names.insert(names.end(), std::begin(trafficParams), std::end(trafficParams));
+    names.insert(names.end(), std::begin(policyParams), std::end(policyParams));
+    uint64_t paramNum = names.size();
+    writer.value(paramNum);
+    for (auto& name : names) {
+        writer.text(name);
+        writer.text(getParam(session.config, name));
+    }
+    int64_t replayFlowNum = session.replay ? (int64_t)session.replay->flows.size() : -1;
+    writer.value(replayFlowNum);
+
+    transferState(writer, session);
+    writer.out.close();
+    return !writer.out.fail();
+}
+
+/*
+目标：
+    从checkpoint恢复session的状态
+思路：
+    1. 检查文件头，读取参数表，结构参数与session.config不同时失败
+    2. trace回放的flow按到达的顺序加入FlowTable，先按同样的顺序补齐，FlowTable的编号与保存时相同
+       再恢复动态状态，任何长度与setup得到的不一致时失败
+    3. 与checkpoint不同的参数从恢复的时刻开始生效：
+       rateAllocator不同时重新分配rate，alpha，delta替换所有滑动窗口里的值，到达过程的参数不同时从time重新安排到达事件
+*/
+bool loadCheckpoint(const std::string& path, SimSession& session, std::string& error) {
+    CheckpointReader reader;
+    reader.in.open(path, std::ios::binary | std::ios::ate);
+    if (!reader.in) {
+        error = "cannot open file";
+        return false;
+    }
+    reader.fileSize = reader.in.tellg();
+    reader.in.seekg(0);
+
+    // 1. 文件头和参数表
+    char magic[4] = {};
+    uint32_t version = 0;
+    reader.in.read(magic, 4);
+    reader.value(version);
+    if (!reader.in || std::memcmp(magic, "SIMC", 4) != 0 || version != 9) {
+        error = "not a checkpoint file";
+        return false;
+    }
+    uint64_t paramNum = 0;
+    reader.value(paramNum);
+    std::map<std::string, std::string> saved;
+    for (uint64_t i = 0; i < paramNum && reader.ok; i++) {
+        std::string name, value;
+        reader.text(name);
+        reader.text(value);
+        saved[name] = value;
+    }
+    if (!reader.ok) {
+        error = "truncated parameter table";
+        return false;
+    }
+    for (const char* name : structuralParams) {
+        std::string value = getParam(session.config, name);
+        if (saved[name] != value) {
+            error = std::string("parameter ") + name + " differs: checkpoint " + saved[name] + ", config " + value;
+            return false;
+        }
+    }
+
+    // 2. 补齐trace回放的flow，恢复动态状态
+    int64_t replayFlowNum = 0;
+    reader.value(replayFlowNum);
+    TraceReplay* replay = session.replay.get();
+    if (!reader.ok || (replay == nullptr) != (replayFlowNum < 0) ||
+        (replay && (replayFlowNum < (int64_t)replay->flows.size() || (uint64_t)replayFlowNum > reader.fileSize))) {
+        error = "trace replay does not match the config";
+        return false;
+    }
+    while (replay && (int64_t)replay->flows.size() < replayFlowNum) {
+        replay->flows.emplace_back(&session.network.flowTable);
+        replay->state.push_back(0);
+        session.network.bgFlowManager.push_back(&replay->flows.back());
+    }
+    transferState(reader, session);
+    if (!reader.ok) {
+        error = "state does not match the network built from the config, or the file is truncated";
+        return false;
+    }
+
+    // 3. what-if的参数
+    const SimConfig& config = session.config;
+    if (saved["rateAllocator"] != getParam(config, "rateAllocator")) {
+        session.network.allocateRate();
+    }
+    // 当前step里已经分配的chunk按原来的大小记账，新的chunk和窗口大小从每个滑动窗口的下一个step开始生效；
+    // 所有step都已经开始时新的参数不会再起作用，不能恢复
+    if (saved["Cnvl"] != getParam(config, "Cnvl") || saved["Cnet"] != getParam(config, "Cnet") ||
+        saved["Wnvl"] != getParam(config, "Wnvl") || saved["Wnet"] != getParam(config, "Wnet")) {
+        RingAllReduce& collective = session.collective;
+        bool stepPending = false;
+        for (size_t s = 0; s < collective.completed.size(); s++) {
+            for (size_t r = 0; r < collective.completed[s].size(); r++) {
+                stepPending = stepPending || collective.completed[s][r] + collective.running[s][r] < collective.stepNum;
+            }
+        }
+        if (!session.schedule && config.mode != SplitMode::Ratio && !stepPending) {
+            error = "Cnvl, Cnet, Wnvl or Wnet differs, but every step has already started and keeps its window";
+            return false;
+        }
+        collective.resetWindows();
+    }
+    if (saved["alpha"] != getParam(config, "alpha") || saved["delta"] != getParam(config, "delta")) {
+        for (auto& server : session.network.serverGroup) {
+            server.alpha = config.alpha;
+            server.delta = config.delta;
+            for (auto& gpu : server.gpus) {
+                gpu.alpha = config.alpha;
+                gpu.delta = config.delta;
+            }
+        }
+    }
+    for (const char* name : trafficParams) {
+        if (saved[name] != getParam(config, name)) {
+            session.traffic.init(config, session.network, session.bgFlows, session.time);
+            break;
+        }
+    }
+    return true;
+}
\ No newline at end of file
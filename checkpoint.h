@@ -0,0 +1,30 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include "session.h"
+
+/*
+模拟状态的二进制checkpoint（小端）：
+    char magic[4] = "SIMC"，uint32 version = 9
+    参数表：uint64 数量，之后每个参数为 name，value 两个字符串（uint64 长度 + 字符）
+    动态状态：time，steps，自适应路由的下一次时刻，trace回放的flow，FlowTable，gpu flow和背景流量的path/links/active，link的流数量，
+              拥塞控制层的队列和每个flow的发送速率，server和gpu的滑动窗口，RingAllReduce或ScheduleCollective的进度和作业的迭代时间，背景流量的事件堆，当前这段发送的到达时刻和随机数stream，FCT统计
+数组都保存为 uint64 长度 + 连续的元素，恢复时整块读入，不需要逐个flow解析
+
+恢复时先用当前的config调用SimSession::setup重建拓扑，路由和所有flow，再覆盖动态的状态，因此：
+    1. 结构参数（拓扑，gpu数量，集合通信和作业，背景流量的模型和数量，seed等）必须与checkpoint相同，否则返回false
+    2. 其他参数可以不同，从checkpoint的时刻开始生效，用同一个checkpoint分出多个what-if：
+       rateAllocator不同时重新分配rate；alpha，delta不同时替换所有滑动窗口的调整参数；
+       Cnvl，Cnet，Wnvl，Wnet不同时每个滑动窗口在自己的下一个step按新的参数重新初始化（当前step已经分配的chunk不变），
+       所有step都已经开始（例如只有一个step的ring）时返回false；
+       背景流量到达过程的参数不同时从checkpoint的时刻重新安排到达事件；telemetry从恢复的时刻开始写新的文件
+*/
+
+// 保存session的全部状态，文件不能写入时返回false
+bool saveCheckpoint(const std::string& path, SimSession& session);
+
+// 从checkpoint恢复session的状态，session已经用config调用过setup；失败时返回false并在error里给出原因
+bool loadCheckpoint(const std::string& path, SimSession& session, std::string& error);
+
+#endif // CHECKPOINT_H
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "collective.h"
+#include <algorithm>
+
+void RingAllReduce::init(Network* network, const SimConfig& config, int stepNum) {
+    this->network = network;
+    this->config = config;
+    this->stepNum = stepNum;
+
+    // 未设置的窗口参数取默认值
+    len = config.len >= 0 ? config.len : config.gpuDataSize;
+    Cnvl = config.Cnvl >= 0 ? config.Cnvl : config.NVLinkBandwidth;
+    Cnet = config.Cnet >= 0 ? config.Cnet : config.topoBW;
+    Wnvl = config.Wnvl >= 0 ? config.Wnvl : Cnvl;
+    Wnet = config.Wnet >= 0 ? config.Wnet : Cnet;
+
+    completed.clear();
+    running.clear();
+    pred.clear();
+    windowReset.clear();
+    startCompletion.clear();
+    startSent.clear();
+    for (auto& server : network->serverGroup) {
+        startCompletion.push_back(std::vector<float>(server.gpus.size() * LINK_CLASS_NUM, 0));
+        startSent.push_back(std::vector<float>(server.gpus.size() * LINK_CLASS_NUM, 0));
+        completed.push_back(std::vector<int>(server.gpus.size(), 0));
+        running.push_back(std::vector<char>(server.gpus.size(), 0));
+        windowReset.push_back(std::vector<char>(server.gpus.size(), 0));
+        std::vector<int> serverPred(server.gpus.size());
+        for (int rank = 0; rank < (int)server.gpus.size(); rank++) {
+            serverPred[server.ring[rank]] = rank;
+        }
+        pred.push_back(serverPred);
+    }
+    stepFinishTime.assign(stepNum, 0);
+}
+
+/*
+目标：
+    gpu开始一个新的step
+思路：
+    1. gpu重新有gpuDataSize的数据待发送，上一个step的chunk统计清零，记录flow当前的completionTime和sentDataSize
+    2. Ratio：按ratio把数据直接分给NVLink和Net两个flow
+    3. GpuWindow：第一个step和windowReset时用配置的窗口参数初始化，之后沿用上一个step调整过的窗口
+    4. ServerWindow由progress对整个server调用Server::initWindow/nextWindow
+*/
+void RingAllReduce::startStep(Server& server, GPU& gpu) {
+    // 1. 新的数据
+    int step = completed[server.id][gpu.rank];
+    running[server.id][gpu.rank] = 1;
+    gpu.isFinished = false;
+    gpu.dataSize = config.gpuDataSize;
+    for (auto& flow : gpu.flows) {
+        flow.chunkDataSize() = 0;
+        startCompletion[server.id][gpu.rank * LINK_CLASS_NUM + flow.linkClass] = flow.completionTime();
+        startSent[server.id][gpu.rank * LINK_CLASS_NUM + flow.linkClass] = flow.sentDataSize();
+    }
+
+    // 2. 按ratio分配
+    if (config.mode == SplitMode::Ratio) {
+        float dataSizeNV = gpu.dataSize * config.ratio;
+        gpu.dataSize -= dataSizeNV;
+        gpu.flowOf(LINK_NVLINK).dataSize() = dataSizeNV;
+
+        float dataSizeNet = gpu.dataSize;
+        gpu.dataSize -= dataSizeNet;
+        gpu.flowOf(LINK_NET).dataSize() = dataSizeNet;
+    }
+    // 3. gpu的滑动窗口
+    else if (config.mode == SplitMode::GpuWindow) {
+        if (step == 0 || windowReset[server.id][gpu.rank]) {
+            gpu.initWindow(len, Cnvl, Cnet, Wnvl, Wnet, config.alpha, config.delta);
+            windowReset[server.id][gpu.rank] = 0;
+        }
+        else {
+            gpu.nextWindow(len);
+        }
+    }
+}
+
+void RingAllReduce::start() {
+    progress(0);
+}
+
+void RingAllReduce::resetWindows() {
+    for (auto& serverReset : windowReset) {
+        std::fill(serverReset.begin(), serverReset.end(), 1);
+    }
+}
+
+/*
+目标：
+    记录完成step的gpu，开始所有输入已经就绪的step
+思路：
+    1. 正在运行且isFinished的gpu完成了当前的step，更新completed和该step的完成时间
+       该step里发送过数据的flow，completionTime的增加量就是它在该step里的完成时间
+    2. Ratio/GpuWindow：没有在运行，还有step没完成，并且ring上的前一个gpu已经完成同一个step的gpu，开始下一个step
+    3. ServerWindow：server里所有gpu都没有在运行并且完成了相同数量的step时，整个server开始下一个step，
+       第一个step和windowReset时用配置的窗口参数初始化server的滑动窗口
+*/
+bool RingAllReduce::progress(float time) {
+    bool started = false;
+    for (auto& server : network->serverGroup) {
+        int s = server.id;
+
+        // 1. 记录完成step的gpu
+        for (auto& gpu : server.gpus) {
+            int r = gpu.rank;
+            if (running[s][r] && gpu.isFinished) {
+                running[s][r] = 0;
+                stepFinishTime[completed[s][r]] = std::max(stepFinishTime[completed[s][r]], time);
+                if (fctStats) {
+                    int stage = stageOf(completed[s][r]);
+                    for (auto& flow : gpu.flows) {
+                        int index = r * LINK_CLASS_NUM + flow.linkClass;
+                        if (flow.sentDataSize() > startSent[s][index]) {
+                            fctStats->add(flow.linkClass, stage, flow.completionTime() - startCompletion[s][index]);
+                        }
+                    }
+                }
+                completed[s][r]++;
+            }
+        }
+
+        // 2. 每个gpu按ring上的依赖开始下一个step
+        if (config.mode != SplitMode::ServerWindow) {
+            for (auto& gpu : server.gpus) {
+                int r = gpu.rank;
+                int step = completed[s][r];
+                if (!running[s][r] && step < stepNum && (step == 0 || completed[s][pred[s][r]] >= step)) {
+                    startStep(server, gpu);
+                    started = true;
+                }
+            }
+            continue;
+        }
+
+        // 3. 整个server开始下一个step
+        int step = completed[s][0];
+        if (step >= stepNum) {
+            continue;
+        }
+        bool ready = true;
+        for (auto& gpu : server.gpus) {
+            if (running[s][gpu.rank] || completed[s][gpu.rank] != step) {
+                ready = false;
+                break;
+            }
+        }
+        if (!ready) {
+            continue;
+        }
+        for (auto& gpu : server.gpus) {
+            startStep(server, gpu);
+        }
+        if (step == 0 || windowReset[s][0]) {
+            server.initWindow(len, Cnvl, Cnet, Wnvl, Wnet, config.alpha, config.delta);
+            std::fill(windowReset[s].begin(), windowReset[s].end(), 0);
+        }
+        else {
+            server.nextWindow(len);
+        }
+        started = true;
+    }
+    return started;
+}
+
+bool RingAllReduce::finished() {
+    for (auto& serverCompleted : completed) {
+        for (int step : serverCompleted) {
+            if (step < stepNum) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// ring只有一个阶段；AllReduce的前gpuNum - 1个step是reduce-scatter，之后是all-gather
+std::vector<std::string> RingAllReduce::stageNames() {
+    if (config.collective == Collective::AllReduce) {
+        return {"reduceScatter", "allGather"};
+    }
+    return {"ring"};
+}
+
+int RingAllReduce::stageOf(int step) {
+    if (config.collective == Collective::AllReduce && step >= config.gpuNum - 1) {
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef COLLECTIVE_H
+#define COLLECTIVE_H
+
+#include <vector>
+#include "network.h"
+#include "simulation.h"
+#include "stats.h"
+
+/*
+ring AllReduce的执行引擎，所有reduce-scatter和all-gather的step都在同一个Network里运行
+    1. 每个step里，gpu把len大小的数据发给ring上的下一个gpu，数据按mode分给NVLink和Net
+    2. gpu完成自己的step s，并且ring上的前一个gpu也完成了step s（收到了step s + 1要发送的数据）时，
+       立即开始step s + 1，不需要等其他gpu，step之间自然形成流水
+    3. ServerWindow时，server的滑动窗口同时给所有gpu分配数据，server里所有gpu都完成step s时才开始step s + 1
+    4. 背景流量，link上的流数量，滑动窗口调整过的窗口大小都保留到下一个step，不需要重新创建网络
+*/
+class RingAllReduce {
+public:
+    Network* network = nullptr;
+    SimConfig config;
+    int stepNum = 1;
+
+    // 按SimConfig里的默认值规则计算好的窗口参数
+    float len, Cnvl, Cnet, Wnvl, Wnet;
+
+    // completed[s][r]：server s里rank r的gpu已经完成的step数量，running[s][r]：是否正在运行一个step
+    std::vector<std::vector<int>> completed;
+    std::vector<std::vector<char>> running;
+    // pred[s][r]：ring上把数据发给rank r的gpu
+    std::vector<std::vector<int>> pred;
+    // windowReset[s][r]：下一个step按Cnvl，Cnet，Wnvl，Wnet重新初始化滑动窗口，而不是沿用调整过的窗口；ServerWindow时看windowReset[s][0]
+    std::vector<std::vector<char>> windowReset;
+
+    // 每个step最后一个gpu完成的时间
+    std::vector<float> stepFinishTime;
+
+    // 不为空时，每个gpu完成一个step时把每个flow在该step里的完成时间加到fctStats里，kind为flow的linkClass
+    FctStats* fctStats = nullptr;
+    // step开始时flow的completionTime和sentDataSize，下标为 rank * LINK_CLASS_NUM + linkClass
+    std::vector<std::vector<float>> startCompletion;
+    std::vector<std::vector<float>> startSent;
+
+    // 初始化引擎，stepNum个step，network里每个gpu已经有NVLink和Net两个flow
+    void init(Network* network, const SimConfig& config, int stepNum);
+
+    // 开始所有gpu的第一个step
+    void start();
+
+    // 窗口参数改变之后（从checkpoint恢复时），所有滑动窗口在各自的下一个step重新初始化，当前step已经分配的chunk不变
+    void resetWindows();
+
+    // 在control之后调用：记录完成step的gpu，开始所有输入已经就绪的step；有新的step开始时返回true
+    bool progress(float time);
+
+    // 所有gpu都完成了所有step
+    bool finished();
+
+    // gpu开始一个新的step
+    void startStep(Server& server, GPU& gpu);
+
+    // 集合通信的阶段名字，stageOf(step)为step所属阶段的编号
+    std::vector<std::string> stageNames();
+    int stageOf(int step);
+};
+
+#endif // COLLECTIVE_H
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "congestion.h"
+#include "network.h"
+#include <algorithm>
+#include <cmath>
+
+void CongestionControl::init(Network& network) {
+    queue.assign(network.linkBW.size(), 0);
+    arrival.assign(network.linkBW.size(), 0);
+    elapsed = 0;
+}
+
+/*
+目标：
+    推进dt时间：积分link的队列，到达period时更新发送速率
+思路：
+    1. dt里每个flow的发送速率不变，到达速率就是上一次assign求出的arrival，队列线性变化，排空之后保持为0
+    2. nextEventTime不会跨过更新时刻，elapsed到达period时更新一次，多出的部分留到下一个period
+*/
+void CongestionControl::advance(Network& network, float dt) {
+    // 1. 队列
+    for (size_t l = 0; l < queue.size(); l++) {
+        queue[l] = std::max(0.0f, queue[l] + (arrival[l] - network.linkBW[l]) * dt);
+    }
+
+    // 2. 速率更新
+    elapsed += dt;
+    while (elapsed >= period) {
+        elapsed -= period;
+        update(network);
+    }
+}
+
+/*
+目标：
+    一次速率更新，只更新正在发送的flow
+思路：
+    1. DCQCN：link的标记概率按队列长度为RED曲线，flow的一个包被标记的概率为 1 - prod(1 - p)，
+       一个period里发送 sendRate * period / packetSize 个包，至少一个被标记时收到CNP
+       收到CNP：alpha = (1 - g) * alpha + g，Rt = Rc，Rc = Rc * (1 - alpha / 2)
+       没有收到：alpha = (1 - g) * alpha，Rc = (Rc + Rt) / 2；连续F = dcqcnFastRecovery次以内Rt不变（快速恢复），
+       F ~ 2F次时Rt每次增加rai（加性增加），超过2F次后第i次增加 i * dcqcnHyperFactor * rai（超快速增加）
+       发送速率不低于线速的千分之一，与网卡的最小速率一致
+    2. Window：路径上的排队时延 = sum(queue / linkBW)，不超过targetDelay时窗口增加 windowAi * 线速 * baseRtt，
+       超过时按超出的比例乘性减小，一次最多减小windowMaxDecrease；发送速率 = 窗口 / (baseRtt + 排队时延)，不超过线速
+*/
+void CongestionControl::update(Network& network) {
+    for (int m = 0; m < 2; m++) {
+        std::vector<Flow*>& flowManager = m == 0 ? network.gpuFlowManager : network.bgFlowManager;
+        for (auto& flow : flowManager) {
+            int f = flow->id;
+            if (!flow->active || !started[f]) {
+                continue;
+            }
+            // 1. DCQCN
+            if (model == CongestionModel::Dcqcn) {
+                double unmarked = 1;
+                for (int l : flow->links) {
+                    double p = 0;
+                    if (queue[l] >= kmax) {
+                        p = 1;
+                    }
+                    else if (queue[l] > kmin) {
+                        p = pmax * (queue[l] - kmin) / (kmax - kmin);
+                    }
+                    unmarked *= 1 - p;
+                }
+                double packets = sendRate[f] * period / packetSize;
+                bool cnp = unmarked < 1 && rng[f].uniform() < 1 - std::pow(unmarked, packets);
+                if (cnp) {
+                    alpha[f] = (1 - dcqcnG) * alpha[f] + dcqcnG;
+                    targetRate[f] = sendRate[f];
+                    sendRate[f] = std::max(sendRate[f] * (1 - alpha[f] / 2), lineRate[f] / 1000);
+                    quietPeriods[f] = 0;
+                }
+                else {
+                    alpha[f] = (1 - dcqcnG) * alpha[f];
+                    int quiet = ++quietPeriods[f];
+                    if (quiet > 2 * dcqcnFastRecovery) {
+                        targetRate[f] = std::min(lineRate[f], targetRate[f] + (float)((quiet - 2 * dcqcnFastRecovery) * dcqcnHyperFactor * rai));
+                    }
+                    else if (quiet > dcqcnFastRecovery) {
+                        targetRate[f] = std::min(lineRate[f], targetRate[f] + rai);
+                    }
+                    sendRate[f] = (sendRate[f] + targetRate[f]) / 2;
+                }
+                continue;
+            }
+
+            // 2. Window
+            float delay = 0;
+            for (int l : flow->links) {
+                delay += queue[l] / network.linkBW[l];
+            }
+            if (delay <= targetDelay) {
+                window[f] += windowAi * lineRate[f] * baseRtt;
+            }
+            else {
+                window[f] *= std::max(1 - windowBeta * (delay - targetDelay) / delay, 1 - windowMaxDecrease);
+            }
+            window[f] = std::min(std::max(window[f], (float)packetSize), lineRate[f] * (baseRtt + delay));
+            sendRate[f] = std::min(lineRate[f], window[f] / (baseRtt + delay));
+        }
+    }
+}
+
+/*
+目标：
+    把发送速率换算成flow实际得到的rate，写入FlowTable
+思路：
+    1. FlowTable里新增的flow（trace回放）补齐状态，每个flow的随机数stream来自network.stream(RNG_CONGESTION, 编号)
+    2. 不再发送的flow清除started；开始发送的flow从线速开始，DCQCN的alpha为1，窗口为一个 线速 * baseRtt
+       换路径的flow由Network::rerouteFlow清除started，在这里按新路径重新计算线速和窗口
+       没有link的flow和经过NVSwitch的NVLink flow不参与拥塞控制，rate与rateAllocator的结果相同
+    3. 到达速率为经过link的所有flow的发送速率之和，flow的rate = 发送速率 * 路径上 min(1, linkBW / 到达速率)
+*/
+void CongestionControl::assign(Network& network) {
+    // 1. 补齐状态
+    size_t flowNum = network.flowTable.size();
+    while (rng.size() < flowNum) {
+        rng.push_back(network.stream(RNG_CONGESTION, rng.size()));
+    }
+    started.resize(flowNum, 0);
+    lineRate.resize(flowNum, 0);
+    sendRate.resize(flowNum, 0);
+    targetRate.resize(flowNum, 0);
+    alpha.resize(flowNum, 0);
+    quietPeriods.resize(flowNum, 0);
+    window.resize(flowNum, 0);
+
+    // 2. 开始和结束发送的flow，到达速率
+    std::fill(arrival.begin(), arrival.end(), 0.0f);
+    for (int m = 0; m < 2; m++) {
+        std::vector<Flow*>& flowManager = m == 0 ? network.gpuFlowManager : network.bgFlowManager;
+        for (auto& flow : flowManager) {
+            int f = flow->id;
+            if (!flow->active || flow->links.empty() || flow->linkClass == LINK_NVLINK) {
+                started[f] = 0;
+                continue;
+            }
+            if (!started[f]) {
+                started[f] = 1;
+                lineRate[f] = FLOAT_MAX;
+                for (int l : flow->links) {
+                    lineRate[f] = std::min(lineRate[f], network.linkBW[l]);
+                }
+                sendRate[f] = targetRate[f] = lineRate[f];
+                alpha[f] = 1;
+                quietPeriods[f] = 0;
+                window[f] = lineRate[f] * baseRtt;
+            }
+            for (int l : flow->links) {
+                arrival[l] += sendRate[f];
+            }
+        }
+    }
+
+    // 3. 实际得到的rate
+    for (int m = 0; m < 2; m++) {
+        std::vector<Flow*>& flowManager = m == 0 ? network.gpuFlowManager : network.bgFlowManager;
+        for (auto& flow : flowManager) {
+            if (!flow->active) {
+                continue;
+            }
+            if (flow->links.empty() || flow->linkClass == LINK_NVLINK) {
+                flow->setRate(network.pathRate(flow));
+                continue;
+            }
+            float scale = 1;
+            for (int l : flow->links) {
+                scale = std::min(scale, network.linkBW[l] / arrival[l]);
+            }
+            flow->setRate(sendRate[flow->id] * scale);
+        }
+    }
+}
+
+void CongestionControl::restart(int f) {
+    if (f < (int)started.size()) {
+        started[f] = 0;
+    }
+}
+
+float CongestionControl::nextUpdateTime(float unitTime) {
+    return std::max(unitTime, std::ceil((period - elapsed) / unitTime) * unitTime);
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef CONGESTION_H
+#define CONGESTION_H
+
+#include <vector>
+#include "rng.h"
+
+class Network;
+
+// 拥塞控制的模型
+enum class CongestionModel {
+    Ideal,  // 没有拥塞控制，rate每次都直接等于速率分配算法（waterFilling/maxMin）给出的公平份额
+    Dcqcn,  // DCQCN：交换机按队列长度做ECN标记，发送端收到CNP时乘性降速，之后快速恢复和加性增加
+    Window  // 基于窗口和时延的AIMD：排队时延低于目标时加性增大窗口，超过目标时按超出的比例减小窗口
+};
+
+/*
+拥塞控制层：每个flow的发送速率随时间按link的队列和ECN标记信号变化，而不是瞬间跳到公平份额
+1. 每条link有一个流体队列（单位Mb），到达速率为经过它的所有flow的发送速率之和，超过带宽的部分进入队列，低于带宽时队列排空
+2. 每隔period按队列更新一次每个flow的发送速率；period之间发送速率不变，Network::nextEventTime不会跨过更新时刻
+3. flow实际得到的rate（写入FlowTable）= 发送速率 * 路径上 min(1, linkBW / 到达速率)，超过带宽的部分只会增加队列
+4. flow开始发送时从线速（路径上最小的linkBW）开始，与RDMA网卡一致
+5. 只控制gpuFlowManager和bgFlowManager里经过交换机网络的flow；经过NVSwitch的NVLink flow没有ECN，rate为速率分配算法的公平份额
+速率分配算法仍然维护link上的流数量；Ideal时不创建这一层，结果与原来完全相同，作为理想的对照
+*/
+class CongestionControl {
+public:
+    // DCQCN里固定的参数：alpha的EWMA增益，快速恢复的次数，超快速增加相对rai的倍数，每个包的大小（1KB，单位Mb）
+    static constexpr double dcqcnG = 1.0 / 256;
+    static constexpr int dcqcnFastRecovery = 5;
+    static constexpr double dcqcnHyperFactor = 10;
+    static constexpr double packetSize = 1024 * 8.0 / (1024 * 1024);
+    // Window里固定的参数：乘性减小的系数和一次最多减小的比例
+    static constexpr double windowBeta = 0.8;
+    static constexpr double windowMaxDecrease = 0.5;
+
+    CongestionModel model = CongestionModel::Dcqcn;
+    float period = 10;   // 速率更新的间隔，单位unitTime
+    float baseRtt = 10;  // 没有排队时的往返时延
+    // DCQCN：队列超过Kmin开始标记，Kmin到Kmax之间标记概率线性增加到Pmax，超过Kmax全部标记；rai为每次加性增加的速率
+    float kmin = 0.04;
+    float kmax = 1.6;
+    float pmax = 0.01;
+    float rai = 0.005;
+    // Window：目标排队时延，每次加性增加的窗口（按线速 * baseRtt的比例）
+    float targetDelay = 20;
+    float windowAi = 0.05;
+
+    // 每条link的队列和到达速率，下标为link编号
+    std::vector<float> queue;
+    std::vector<float> arrival;
+
+    // 每个flow的状态，下标为flow在FlowTable里的编号，flow发送完之后started为0，下次开始发送时重新初始化
+    std::vector<char> started;
+    std::vector<float> lineRate;   // 路径上最小的linkBW
+    std::vector<float> sendRate;   // 当前的发送速率（DCQCN的Rc）
+    std::vector<float> targetRate; // DCQCN的Rt
+    std::vector<float> alpha;      // DCQCN的alpha
+    std::vector<int> quietPeriods; // DCQCN上一次收到CNP之后的更新次数
+    std::vector<float> window;     // Window的窗口大小，单位Mb
+    std::vector<RandomStream> rng; // DCQCN是否收到CNP的随机数，stream的index为flow的编号
+
+    float elapsed = 0; // 上一次更新速率之后经过的时间
+
+    // network的link和flow已经创建，分配队列
+    void init(Network& network);
+
+    // 在control里每个tick调用一次：按过去dt时间里的发送速率积分队列，到达period时更新每个flow的发送速率
+    void advance(Network& network, float dt);
+
+    // 在updateRate之后调用：初始化开始发送的flow，重新计算到达速率，把实际得到的rate写入FlowTable
+    void assign(Network& network);
+
+    // flow换了路径，下次assign时按新路径重新初始化线速和窗口
+    void restart(int f);
+
+    // 距离下一次速率更新的时间，向上取整为unitTime的整数倍
+    float nextUpdateTime(float unitTime);
+
+    // 一次速率更新
+    void update(Network& network);
+};
+
+#endif // CONGESTION_H
\ No newline at end of file
@@ -1,30 +1,38 @@
 #include "flow.h"
 
-Flow::Flow(int srcId, int dstId, float dataSize, std::string protocol) {
+Flow::Flow(FlowTable* table) {
+    this->table = table;
+    this->id = table->add(0);
+}
+
+Flow::Flow(FlowTable* table, int srcId, int dstId, float dataSize, int linkClass) {
+    this->table = table;
+    this->id = table->add(dataSize);
     this->srcId = srcId;
     this->dstId = dstId;
-    this->dataSize = dataSize;
-    this->protocol = protocol;
+    this->linkClass = linkClass;
 }
 
-Flow::Flow(std::pair<int, int> src, std::pair<int, int> dst, float dataSize, std::string protocol) {
+Flow::Flow(FlowTable* table, std::pair<int, int> src, std::pair<int, int> dst, float dataSize, int linkClass) {
+    this->table = table;
+    this->id = table->add(dataSize);
     this->src = src;
     this->dst = dst;
-    this->dataSize = dataSize;
-    this->protocol = protocol;
+    this->linkClass = linkClass;
 }
 
-void Flow::init(std::pair<int, int> src, std::pair<int, int> dst, float dataSize, std::string protocol) {
+void Flow::init(std::pair<int, int> src, std::pair<int, int> dst, float dataSize, int linkClass) {
     this->src = src;
     this->dst = dst;
-    this->dataSize = dataSize;
-    this->protocol = protocol;
+    this->dataSize() = dataSize;
+    this->linkClass = linkClass;
 }
 
 void Flow::setRate(float rate) {
-    this->rate = rate;
+    this->rate() = rate;
 }
 
 void Flow::setPath(std::vector<int> path) {
     this->path = path;
+    this->links.clear();
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <vector>
 #include <utility>
 #include "constants.h"
+#include "flow_table.h"
+#include "link_class.h"
 
 class Flow {
 public:
@@ -13,27 +15,40 @@ public:
     std::pair<int, int> dst;
     int srcId; // 在topo中的src节点编号
     int dstId; // 在topo中的dst节点编号
-    float completionTime = 0;
-    float chunkDataSize = 0;
-    float sentDataSize = 0;
-    float dataSize = 0;
-    std::string protocol;
+    int linkClass; // 传输类型，见link_class.h
+
+    // completionTime，chunkDataSize，sentDataSize，dataSize和rate这些每个时间片都会访问的字段保存在FlowTable里，
+    // Flow只记录自己在FlowTable里的编号
+    FlowTable* table;
+    int id;
 
     // 待计算参数
-    float rate = 0;
     std::vector<int> path;
 
-    // Flow默认构造函数
-    Flow() {}
+    // path上每一跳的link编号，由Network::resolveLinks根据path求出，setPath时清空
+    std::vector<int> links;
+
+    // 该flow是否已经计入path上每条link的流数量
+    bool active = false;
+
+    // Flow构造函数，在table里新增一个dataSize为0的flow
+    Flow(FlowTable* table);
 
     // Flow构造函数
-    Flow(int srcId, int dstId, float dataSize, std::string protocol);
+    Flow(FlowTable* table, int srcId, int dstId, float dataSize, int linkClass);
 
     // Flow构造函数，带参数
-    Flow(std::pair<int, int> src, std::pair<int, int> dst, float dataSize, std::string protocol);
+    Flow(FlowTable* table, std::pair<int, int> src, std::pair<int, int> dst, float dataSize, int linkClass);
 
     // Flow的初始化函数，给Flow的每个成员变量都赋值
-    void init(std::pair<int, int> src, std::pair<int, int> dst, float dataSize, std::string protocol);
+    void init(std::pair<int, int> src, std::pair<int, int> dst, float dataSize, int linkClass);
+
+    // FlowTable里的字段
+    float& dataSize() { return table->dataSize[id]; }
+    float& rate() { return table->rate[id]; }
+    float& sentDataSize() { return table->sentDataSize[id]; }
+    float& completionTime() { return table->completionTime[id]; }
+    float& chunkDataSize() { return table->chunkDataSize[id]; }
 
     // 设置rate
     void setRate(float rate);
@@ -42,4 +57,4 @@ public:
     void setPath(std::vector<int> path);
 };
 
-#endif // FLOW_H
+#endif // FLOW_H
\ No newline at end of file
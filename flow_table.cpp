@@ -0,0 +1,59 @@
+#include "flow_table.h"
+#include <algorithm>
+#include <cmath>
+
+int FlowTable::add(float dataSize) {
+    this->dataSize.push_back(dataSize);
+    rate.push_back(0);
+    sentDataSize.push_back(0);
+    completionTime.push_back(0);
+    chunkDataSize.push_back(0);
+    return this->dataSize.size() - 1;
+}
+
+int FlowTable::size() {
+    return dataSize.size();
+}
+
+/*
+目标：
+    一次遍历所有flow，dataSize = dataSize - rate * unitTime，直至dataSize为0
+思路：
+    1. sent = min(dataSize, rate * unitTime)，dataSize恰好发送完时与原来的逐flow判断结果完全一致
+    2. 只用min/max和选择，不带分支，循环体可以被编译器向量化
+    3. dataSize > 0的flow累加completionTime
+*/
+void FlowTable::drain(float unitTime) {
+    drain(unitTime, 0, size());
+}
+
+void FlowTable::drain(float unitTime, int begin, int end) {
+    float* __restrict d = dataSize.data();
+    const float* __restrict r = rate.data();
+    float* __restrict sent = sentDataSize.data();
+    float* __restrict ct = completionTime.data();
+    for (int i = begin; i < end; i++) {
+        float remain = std::max(d[i], 0.0f);
+        float s = std::min(remain, r[i] * unitTime);
+        ct[i] += remain > 0 ? unitTime : 0.0f;
+        sent[i] += s;
+        d[i] = remain - s;
+    }
+}
+
+// 按当前rate发送完剩余dataSize所需的时间，向上取整为unitTime的整数倍，对所有flow一次遍历求最小值；没有会发送完的flow时返回FLOAT_MAX
+float FlowTable::nextDrainTime(float unitTime) {
+    int n = size();
+    const float* d = dataSize.data();
+    const float* r = rate.data();
+    const float noEvent = FLOAT_MAX;
+    float ticks = noEvent;
+    for (int i = 0; i < n; i++) {
+        float t = (d[i] > 0 && r[i] > 0) ? d[i] / (r[i] * unitTime) : noEvent;
+        ticks = std::min(ticks, t);
+    }
+    if (ticks == noEvent) {
+        return noEvent;
+    }
+    return std::max(std::ceil(ticks), 1.0f) * unitTime;
+}
@@ -0,0 +1,35 @@
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+#include <vector>
+#include "constants.h"
+
+/*
+所有flow的热字段按struct-of-arrays连续存放，下标就是flow的编号
+Flow只保存编号和src，dst，linkClass，path这些不在每个时间片里访问的字段
+step里对所有flow（gpu里的flow和背景流量）只做一次连续的遍历，编译器可以向量化
+*/
+class FlowTable {
+public:
+    std::vector<float> dataSize;       // 待发送的数据大小
+    std::vector<float> rate;           // 当前分配到的rate
+    std::vector<float> sentDataSize;   // 已经发送的数据大小
+    std::vector<float> completionTime; // 有数据待发送的累计时间
+    std::vector<float> chunkDataSize;  // 滑动窗口分配给该flow的数据大小
+
+    // 新增一个flow，返回它的编号
+    int add(float dataSize);
+
+    int size();
+
+    // 所有flow按rate发送unitTime时间的数据，dataSize减少为0，不会为负数
+    void drain(float unitTime);
+
+    // 只处理编号在[begin, end)里的flow，用于分片并行
+    void drain(float unitTime, int begin, int end);
+
+    // 所有flow里最早发送完的时间，向上取整为unitTime的整数倍；没有flow会发送完时返回FLOAT_MAX
+    float nextDrainTime(float unitTime);
+};
+
+#endif // FLOW_TABLE_H
@@ -5,6 +5,7 @@ GPU::GPU(int rank, float dataSize, bool isFinished) {
     this->rank = rank;
     this->dataSize = dataSize;
     this->isFinished = isFinished;
+    std::fill(flowIndex, flowIndex + LINK_CLASS_NUM, -1);
 }
 
 // GPU的初始化函数，给GPU的每个成员变量都赋值
@@ -13,122 +14,122 @@ void GPU::init(int rank, float dataSize, bool isFinished) {
     this->dataSize = dataSize;
     this->isFinished = isFinished;
     this->len = dataSize;
+    std::fill(flowIndex, flowIndex + LINK_CLASS_NUM, -1);
+}
+
+// 把flow加入到flows中，并按flow的传输类型记录下标
+void GPU::addFlow(Flow flow) {
+    flowIndex[flow.linkClass] = flows.size();
+    flows.push_back(flow);
+}
+
+Flow& GPU::flowOf(int linkClass) {
+    return flows[flowIndex[linkClass]];
 }
 
 // 对滑动窗口的初始化
-void GPU::initWindow(float len, float Cnvl, float Cnet, float Wnvl, float Wnet, float alpha, float delta) {
+void GPU::initWindow(float len, float Cleft, float Cright, float Wleft, float Wright, float alpha, float delta) {
     this->len = len;
-    this->Cnvl = Cnvl;
-    this->Cnet = Cnet;
+    chunk[leftClass] = Cleft;
+    chunk[rightClass] = Cright;
     this->alpha = alpha;
     this->delta = delta;
     // 开始判断
     
-    // 在这两种情况下，分配给NVLink和Net的数据都固定好了，窗口不需要滑动了
-    if (this->len <= std::min(Wnvl, Wnet)) { // len < Wnvl && len < Wnet
-        this->Wnvl = this->len;
-        this->Wnet = 0;
-        flows[0].dataSize = this->Wnvl;
+    // 在这两种情况下，分配给leftClass和rightClass的数据都固定好了，窗口不需要滑动了
+    if (this->len <= std::min(Wleft, Wright)) { // len < Wleft && len < Wright
+        window[leftClass] = this->len;
+        window[rightClass] = 0;
+        flowOf(leftClass).dataSize() = window[leftClass];
         this->dataSize = 0;
         return;
     }
-    else if (len <= Wnvl + Wnet) { // len < Wnet < Wnvl
-        this->Wnvl = Wnvl;
-        this->Wnet = len - Wnvl;
-        flows[0].dataSize = this->Wnvl;
-        flows[1].dataSize = this->Wnet;
+    else if (len <= Wleft + Wright) { // len < Wright < Wleft
+        window[leftClass] = Wleft;
+        window[rightClass] = len - Wleft;
+        flowOf(leftClass).dataSize() = window[leftClass];
+        flowOf(rightClass).dataSize() = window[rightClass];
         this->dataSize = 0;
         return;
     }
-    this->Wnet = Wnet;
-    this->Wnvl = Wnvl;
-    left = this->Wnvl;
-    right = len - this->Wnet;
-    // 分配一个Cnvl和Cnet给flows[0]和flows[1]
-    sendChunk("NVLink");
-    sendChunk("Net");
+    window[rightClass] = Wright;
+    window[leftClass] = Wleft;
+    left = window[leftClass];
+    right = len - window[rightClass];
+    // 分配一个chunk给leftClass和rightClass的flow
+    sendChunk(leftClass);
+    sendChunk(rightClass);
     return;
 }
 
-bool GPU::rankFinish(std::string protocol) {
-    if (protocol == "NVLink" && flows[0].dataSize <= 0) {
-        return true;
+// 窗口状态保留到下一段数据，chunk的统计清零
+void GPU::nextWindow(float len) {
+    for (auto& flow : flows) {
+        flow.chunkDataSize() = 0;
     }
-    else if (protocol == "Net" && flows[1].dataSize <= 0) {
+    initWindow(len, chunk[leftClass], chunk[rightClass], window[leftClass], window[rightClass], alpha, delta);
+}
+
+// 该传输类型的flow是否已经发送完，gpu上没有该类型的flow时也视为发送完
+bool GPU::rankFinish(int linkClass) {
+    if (flowIndex[linkClass] == -1) {
         return true;
     }
-    else {
-        return false;
-    }
+    return flowOf(linkClass).dataSize() <= 0;
 }
 
-void GPU::sendChunk(std::string protocol) {
-    if (protocol == "NVLink") {
-        if (dataSize > Cnvl) {
-            flows[0].dataSize += Cnvl;
-            flows[0].chunkDataSize += Cnvl;
-            dataSize -= Cnvl;
-        }
-        else {
-            flows[0].dataSize += dataSize;
-            flows[0].chunkDataSize += dataSize;
-            dataSize = 0;
-        }
-    }
-    else if (protocol == "Net") {
-        if (dataSize > Cnet) {
-            flows[1].dataSize += Cnet;
-            flows[1].chunkDataSize += Cnet;
-            dataSize -= Cnet;
-        }
-        else {
-            flows[1].dataSize += dataSize;
-            flows[1].chunkDataSize += dataSize;
-            dataSize = 0;
-        }
-    }
+// 从gpu剩余的dataSize里分配一个chunk给该传输类型的flow
+void GPU::sendChunk(int linkClass) {
+    Flow& flow = flowOf(linkClass);
+    float size = std::min(dataSize, chunk[linkClass]);
+    dataSize -= size;
+    flow.dataSize() += size;
+    flow.chunkDataSize() += size;
 }
 
-// 计算函数，根据当前的left和right，判断是否需要发送chunk给NVLink或者Network
+// 计算函数，根据当前的left和right，判断是否需要发送chunk给leftClass（NVLink）或者rightClass（Network）
 void GPU::computing(float unitTime) {
     if (left == -1 && right == -1) {
         return;
     }
     else if (0 < left && left < right) {
-        if (rankFinish("NVLink")) { //
-            left += Cnvl; // 考虑left与right临近时，可能有一定重叠，但是对仿真结果影响不大
-            sendChunk("NVLink");
+        if (rankFinish(leftClass)) { //
+            left += chunk[leftClass]; // 考虑left与right临近时，可能有一定重叠，但是对仿真结果影响不大
+            sendChunk(leftClass);
         }
-        if (left < right && rankFinish("Net")) {
+        if (left < right && rankFinish(rightClass)) {
+            float Cright = chunk[rightClass];
             if (timeChunkNow - timeChunkLast < delta) { // 假设delta是你已经定义的变量
-                Wnet += alpha * Cnet; // 假设alpha是你已经定义的变量
-                right -= (alpha + 1) * Cnet;
-                sendChunk("Net");
-            } else if (Wnet > Cnet) {
-                Wnet -= Cnet;
+                window[rightClass] += alpha * Cright; // 假设alpha是你已经定义的变量
+                right -= (alpha + 1) * Cright;
+                sendChunk(rightClass);
+            } else if (window[rightClass] > Cright) {
+                window[rightClass] -= Cright;
                 //return;
             }
             else {
-                right -= Cnet;
-                sendChunk("Net");
+                right -= Cright;
+                sendChunk(rightClass);
             }
             timeChunkLast = timeChunkNow;
             timeChunkNow = 0;
         }
     }
     else if(left >= right && right > 0){
-        flows[0].dataSize -= Cnvl; // 去掉left++时的sendChunk, left后退一格chunk
-        flows[0].chunkDataSize -= Cnvl;
+        Flow& leftFlow = flowOf(leftClass);
+        Flow& rightFlow = flowOf(rightClass);
+        leftFlow.dataSize() -= chunk[leftClass]; // 去掉left++时的sendChunk, left后退一格chunk
+        leftFlow.chunkDataSize() -= chunk[leftClass];
         // 考虑如果left和right如果重叠，那么right保持不变，left后退一点到right的值
-        float nvlDataSize = right - flows[0].chunkDataSize;
+        float leftDataSize = right - leftFlow.chunkDataSize();
         
-        float netDataSize = (len - right) - flows[1].chunkDataSize;
+        float rightDataSize = (len - right) - rightFlow.chunkDataSize();
 
-        dataSize -= nvlDataSize;
-        dataSize -= netDataSize;
+        dataSize -= leftDataSize;
+        dataSize -= rightDataSize;
 
-        flows[0].dataSize += nvlDataSize;
-        flows[1].dataSize += netDataSize;
+        leftFlow.dataSize() += leftDataSize;
+        rightFlow.dataSize() += rightDataSize;
 
         left = -1;
         right = -1;
@@ -136,27 +137,12 @@ void GPU::computing(float unitTime) {
 }
 
 /* 
-遍历flows，对每个flow根据flow的rate，减少flow的dataSize，
-dataSize = dataSize - rate * unitTime
-直至flow的dataSize都为0，将不再参与计算
+flows的dataSize = dataSize - rate * unitTime 由FlowTable::drain对所有flow一次遍历完成，
+这里只需要累加距离上一个chunk的时间
 */
 
-// 通信函数，根据flows的rate，减少flows的dataSize, 但是dataSize减少为0，不会为负数
+// 通信函数，flows的发送由FlowTable::drain完成
 void GPU::communication(float unitTime) {
-    float epsilon = 1e-5;
-    for (auto& flow : flows) {
-        if (flow.dataSize > 0) {
-            if (flow.dataSize > flow.rate * unitTime) {
-                flow.dataSize -= flow.rate * unitTime;
-                flow.sentDataSize += flow.rate * unitTime;
-            }
-            else {
-                flow.sentDataSize += flow.dataSize;
-                flow.dataSize = 0;
-            }
-            flow.completionTime += unitTime;
-        }
-    }
     timeChunkNow += unitTime;
 }
 
@@ -166,8 +152,8 @@ void GPU::isWorkFinished() {
     if (dataSize > epsilon) {
         return;
     }
-    for (const auto& flow : flows) {
-        if (flow.dataSize > epsilon) {
+    for (auto& flow : flows) {
+        if (flow.dataSize() > epsilon) {
             return;
         }
     }
@@ -183,4 +169,19 @@ void GPU::step(float unitTime) {
 void GPU::control(float unitTime) {
     computing(unitTime);
     isWorkFinished();
+}
+
+/*
+目标：
+    判断该gpu的滑动窗口是否需要在下一个unitTime做决策，需要时事件驱动的仿真不能跳过下一个unitTime
+思路：
+    1. 滑动窗口没有在运行（left和right都为-1）时返回false
+    2. 只要有一个传输类型的flow发送完，或者left >= right需要收尾，computing在下一个unitTime就会做决策，返回true
+    3. 否则返回false，flow发送完的时刻由Network::nextEventTime从flowTable求出
+*/
+bool GPU::windowPending() {
+    if (left == -1 && right == -1) {
+        return false;
+    }
+    return left >= right || rankFinish(leftClass) || rankFinish(rightClass);
 }
\ No newline at end of file
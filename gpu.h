@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <vector>
 #include "flow.h"
+#include "link_class.h"
 
 class GPU {
 public:
@@ -11,13 +12,15 @@ public:
     float dataSize;
     bool isFinished;
     std::vector<Flow> flows; // Vector of Flow objects
+    int flowIndex[LINK_CLASS_NUM]; // 每种传输类型的flow在flows里的下标，没有该类型的flow时为-1
 
     // 有关滑动窗口的变量
+    // 窗口从左边分配数据给leftClass（默认NVLink），从右边分配数据给rightClass（默认Net）
+    int leftClass = LINK_NVLINK;
+    int rightClass = LINK_NET;
+    float chunk[LINK_CLASS_NUM] = {};  // 每种传输类型每次分配的chunk大小，Cnvl = chunk[LINK_NVLINK]
+    float window[LINK_CLASS_NUM] = {}; // 每种传输类型的窗口大小，Wnvl = window[LINK_NVLINK]
     float len; // len = dataSize;
-    float Cnvl;
-    float Cnet;
-    float Wnvl;
-    float Wnet;
     float left = -1;
     float right = -1;
     float timeChunkZero = FLOAT_MAX; // Time of the zero chunk
@@ -31,12 +34,21 @@ public:
 
     void init(int rank, float dataSize, bool isFinished);
 
-    //对滑动窗口的初始化
-    void initWindow(float len, float Cnvl, float Cnet, float Wnvl, float Wnet, float alpha, float delta);
+    // 把flow加入到flows中，并按flow的传输类型记录下标
+    void addFlow(Flow flow);
 
-    bool rankFinish(std::string protocol);
+    // 该gpu上某种传输类型的flow
+    Flow& flowOf(int linkClass);
 
-    void sendChunk(std::string protocol);
+    //对滑动窗口的初始化，Cleft，Wleft是leftClass的chunk和窗口大小，Cright，Wright是rightClass的
+    void initWindow(float len, float Cleft, float Cright, float Wleft, float Wright, float alpha, float delta);
+
+    // 用当前的chunk和窗口大小（可能已经被alpha调整过）为新的一段数据重新开始滑动窗口
+    void nextWindow(float len);
+
+    bool rankFinish(int linkClass);
+
+    void sendChunk(int linkClass);
 
     void computing(float unitTime);
 
@@ -47,6 +59,9 @@ public:
     void step(float unitTime);
 
     void control(float unitTime);
+
+    // 滑动窗口是否需要在下一个unitTime做决策
+    bool windowPending();
 };
 
 #endif // GPU_H
\ No newline at end of file
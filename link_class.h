@@ -0,0 +1,33 @@
+#ifndef LINK_CLASS_H
+#define LINK_CLASS_H
+
+#include <string>
+
+/*
+传输类型（link class）的注册表
+每种传输类型有一个编号，GPU里每种传输类型最多有一个flow，用编号直接索引，
+step和control里只比较编号，不再比较字符串
+新增传输类型时，在LINK_CLASS_NUM前加一个编号，并在linkClassName里加上它的名字
+*/
+enum LinkClass {
+    LINK_NVLINK = 0,    // server内部的NVLink
+    LINK_NET = 1,       // server外部的网络
+    LINK_PCIE = 2,      // server内部的PCIe
+    LINK_NET_RAIL1 = 3, // 第二个网卡的网络
+    LINK_CLASS_NUM
+};
+
+// 每种传输类型的名字，只在初始化和打印结果时使用
+const char* const linkClassName[LINK_CLASS_NUM] = {"NVLink", "Net", "PCIe", "NetRail1"};
+
+// 根据名字查找传输类型的编号，找不到时返回-1，只在初始化时使用
+inline int findLinkClass(const std::string& name) {
+    for (int linkClass = 0; linkClass < LINK_CLASS_NUM; linkClass++) {
+        if (name == linkClassName[linkClass]) {
+            return linkClass;
+        }
+    }
+    return -1;
+}
+
+#endif // LINK_CLASS_H
\ No newline at end of file
@@ -3,6 +3,14 @@
 // Network构造函数的实现
 Network::Network() {}
 
+void Network::seed(uint64_t seed) {
+    masterSeed = seed;
+}
+
+RandomStream Network::stream(uint64_t component, uint64_t index) {
+    return RandomStream(masterSeed, component, index);
+}
+
 // init函数的实现
 void Network::init(int serverGroupNum, int gpuNum, float gpuDataSize, std::vector<std::vector<float>> NVLink, float topoBW) {
     this->serverGroupNum = serverGroupNum;
@@ -10,307 +18,838 @@ void Network::init(int serverGroupNum, int gpuNum, float gpuDataSize, std::vecto
     this->gpuDataSize = gpuDataSize;
     this->NVLink = NVLink;
     this->topoBW = topoBW;
-    this->nodeNum = (serverGroupNum * gpuNum) + leafNum + spineNum;
+    this->gpuTotal = serverGroupNum * gpuNum;
 
     /*
     目标：
-        初始化网络拓扑topo，设置网络带宽
+        初始化网络拓扑，设置网络带宽
     思路：
-        1. 初始化topo为nodeNum x nodeNum的零矩阵
-        2. 初始化serverGroup里的gpu与leaf的连接：
-            每个server有gpuNum = 8个gpu且gpuNum = leafNum = 8，gpu0与leaf0相连，gpu1与leaf1相连，以此类推
-            gpu之间没有连接，只有gpu与leaf之间有连接
-        3. leaf与spine之间全连接，但leaf之间没有连接，spine之间没有连接
-
+        1. 按topoType生成所有存在的link，同时求出各层节点的编号范围和每个gpu连接的leaf，再加上每个server的NVSwitch
+        2. 用buildLinks生成CSR表示的拓扑，内存只与link数量有关，再用pathCache预处理leaf之间的最短路径，NVSwitch不参与
+        3. 初始化serverGroup
     */
-    // 1. 初始化topo为nodeNum x nodeNum的零矩阵
-    topo = std::vector<std::vector<std::pair<int, float>>>(nodeNum, std::vector<std::pair<int, float>>(nodeNum, {0, 0}));
-    
-    // 2. 初始化serverGroup里的gpu与leaf的连接：
+    // 1. 生成link
+    std::vector<std::pair<std::pair<int, int>, float>> edges;
+    if (topoType == TopoType::FatTree) {
+        buildFatTree(edges);
+    }
+    else {
+        buildLeafSpine(edges);
+    }
+    buildNVSwitch(edges);
+
+    // 2. CSR表示的拓扑，leaf之间的等价最短路径
+    buildLinks(edges);
+    pathCache.build(leafBase, leafNum, nvswitchBase, linkOffset, linkDst);
+
+    // 3. 初始化serverGroup
+    for (int i = 0; i < serverGroupNum; i++) {
+        serverGroup.push_back(Server(i, gpuNum, gpuDataSize, NVLink));
+    }
+}
+
+/*
+目标：
+    生成两层leaf/spine Clos
+思路：
+    1. 每个leaf有radix个端口，按oversubscription分为下行（连接gpu）和上行（连接spine）：down : up = oversubscription : 1
+    2. 按rank分rail：rank r的gpu只连接rail r的leaf，每个rail有 ceil(serverGroupNum / down) 个leaf，
+       server s里rank r的gpu连接rail r里第 s / down 个leaf
+    3. spine的数量为up，每个leaf与每个spine之间有一条link，leaf之间没有连接，spine之间没有连接
+    默认radix = 16，oversubscription = 1，8server 8gpu时：down = up = 8，leaf = 8，spine = 8，gpu rank r连接leaf r
+*/
+void Network::buildLeafSpine(std::vector<std::pair<std::pair<int, int>, float>>& edges) {
+    // 1. 下行和上行的端口数
+    int down = std::max(1, (int)std::lround(radix * oversubscription / (1 + oversubscription)));
+    down = std::min(down, radix - 1);
+    int up = radix - down;
+
+    // 2. 节点编号的范围
+    int leavesPerRail = (serverGroupNum + down - 1) / down;
+    leafBase = gpuTotal;
+    leafNum = gpuNum * leavesPerRail;
+    aggBase = leafBase + leafNum;
+    aggNum = 0;
+    spineBase = aggBase;
+    spineNum = up;
+    podSize = 0;
+    nodeNum = spineBase + spineNum;
+
+    // 3. gpu与leaf的连接
+    gpuLeaf.assign(gpuTotal, -1);
     for (int serverId = 0; serverId < serverGroupNum; ++serverId) {
         for (int gpuRank = 0; gpuRank < gpuNum; ++gpuRank) {
             int gpuId = serverId * gpuNum + gpuRank;
-            int leafId = serverGroupNum * gpuNum + gpuRank;
+            int leafId = leafBase + gpuRank * leavesPerRail + serverId / down;
+            gpuLeaf[gpuId] = leafId;
 
-            topo[gpuId][leafId] = {0, topoBW}; // 初始化流数量为0，带宽为NVLink[gpu][gpu]
-            topo[leafId][gpuId] = {0, topoBW}; // 初始化流数量为0，带宽为NVLink[gpu][gpu]
+            edges.push_back({{gpuId, leafId}, topoBW}); // 带宽为topoBW
+            edges.push_back({{leafId, gpuId}, topoBW}); // 带宽为topoBW
         }
     }
 
-    // 3. leaf与spine之间全连接，但leaf之间没有连接，spine之间没有连接
+    // 4. leaf与spine之间全连接
     for (int leaf = 0; leaf < leafNum; ++leaf) {
         for (int spine = 0; spine < spineNum; ++spine) {
-            int leafId = serverGroupNum * gpuNum + leaf;
-            int spineId = serverGroupNum * gpuNum + leafNum + spine;
+            int leafId = leafBase + leaf;
+            int spineId = spineBase + spine;
 
-            topo[leafId][spineId] = {0, topoBW}; // 初始化流数量为0，带宽为topoBW
-            topo[spineId][leafId] = {0, topoBW}; // 初始化流数量为0，带宽为topoBW
+            edges.push_back({{leafId, spineId}, topoBW}); // 带宽为topoBW
+            edges.push_back({{spineId, leafId}, topoBW}); // 带宽为topoBW
         }
     }
+}
 
+/*
+目标：
+    生成k-ary fat-tree，k = radix
+思路：
+    1. 每个pod有k / 2个edge和k / 2个aggregation，每个edge连接k / 2个gpu，core有 (k / 2)^2 个
+       只生成放下所有gpu需要的pod数量，gpu少于 k^3 / 4 时是一个不完整的fat-tree
+    2. 与LeafSpine一样按rank分rail，gpu按 rank * serverGroupNum + serverId 的顺序依次连接edge
+    3. pod里的edge与aggregation全连接；每个pod里第j个aggregation连接第 j * k / 2 ~ (j + 1) * k / 2 - 1 个core
+    4. edge以上的link带宽为 topoBW / oversubscription
+*/
+void Network::buildFatTree(std::vector<std::pair<std::pair<int, int>, float>>& edges) {
+    // 1. 节点编号的范围
+    podSize = std::max(1, radix / 2);
+    int edgeNeeded = (gpuTotal + podSize - 1) / podSize;
+    int podNum = (edgeNeeded + podSize - 1) / podSize;
+    leafBase = gpuTotal;
+    leafNum = podNum * podSize;
+    aggBase = leafBase + leafNum;
+    aggNum = podNum * podSize;
+    spineBase = aggBase + aggNum;
+    spineNum = podSize * podSize;
+    nodeNum = spineBase + spineNum;
+    float upBW = topoBW / oversubscription;
+
+    // 2. gpu与edge的连接
+    gpuLeaf.assign(gpuTotal, -1);
+    for (int serverId = 0; serverId < serverGroupNum; ++serverId) {
+        for (int gpuRank = 0; gpuRank < gpuNum; ++gpuRank) {
+            int gpuId = serverId * gpuNum + gpuRank;
+            int leafId = leafBase + (gpuRank * serverGroupNum + serverId) / podSize;
+            gpuLeaf[gpuId] = leafId;
 
+            edges.push_back({{gpuId, leafId}, topoBW});
+            edges.push_back({{leafId, gpuId}, topoBW});
+        }
+    }
 
-    // 初始化serverGroup
-    for (int i = 0; i < serverGroupNum; i++) {
-        serverGroup.push_back(Server(i, gpuNum, gpuDataSize, NVLink));
+    // 3. pod里edge与aggregation全连接，aggregation与core的连接
+    for (int pod = 0; pod < podNum; ++pod) {
+        for (int i = 0; i < podSize; ++i) {
+            int leafId = leafBase + pod * podSize + i;
+            for (int j = 0; j < podSize; ++j) {
+                int aggId = aggBase + pod * podSize + j;
+                edges.push_back({{leafId, aggId}, upBW});
+                edges.push_back({{aggId, leafId}, upBW});
+            }
+        }
+        for (int j = 0; j < podSize; ++j) {
+            int aggId = aggBase + pod * podSize + j;
+            for (int c = 0; c < podSize; ++c) {
+                int coreId = spineBase + j * podSize + c;
+                edges.push_back({{aggId, coreId}, upBW});
+                edges.push_back({{coreId, aggId}, upBW});
+            }
+        }
     }
 }
 
+/*
+目标：
+    生成每个server里的NVSwitch，server内的NVLink流量经过它共享每个gpu的NVLink带宽
+思路：
+    1. 每个server一个NVSwitch节点，编号接在交换机网络之后
+    2. gpu到NVSwitch的link带宽为gpu的出口带宽 max(NVLink[rank][j])，NVSwitch到gpu的link带宽为入口带宽 max(NVLink[i][rank])
+       一个gpu同时发给多个peer时，这些flow在出口link上分享带宽，而不是每个都得到完整的NVLink带宽
+*/
+void Network::buildNVSwitch(std::vector<std::pair<std::pair<int, int>, float>>& edges) {
+    // 1. NVSwitch的编号
+    nvswitchBase = nodeNum;
+    nodeNum += serverGroupNum;
+
+    // 2. gpu与NVSwitch的连接
+    for (int serverId = 0; serverId < serverGroupNum; ++serverId) {
+        int nvswitchId = nvswitchBase + serverId;
+        for (int gpuRank = 0; gpuRank < gpuNum; ++gpuRank) {
+            int gpuId = serverId * gpuNum + gpuRank;
+            float egress = 0;
+            float ingress = 0;
+            for (int peer = 0; peer < gpuNum; ++peer) {
+                if (peer != gpuRank) {
+                    egress = std::max(egress, NVLink[gpuRank][peer]);
+                    ingress = std::max(ingress, NVLink[peer][gpuRank]);
+                }
+            }
+            if (egress > 0) {
+                edges.push_back({{gpuId, nvswitchId}, egress});
+            }
+            if (ingress > 0) {
+                edges.push_back({{nvswitchId, gpuId}, ingress});
+            }
+        }
+    }
+}
+
+/*
+目标：
+    实现buildLinks函数，根据link列表生成CSR表示的网络拓扑
+思路：
+    1. 按(src, dst)排序，统计每个节点出发的link数量，前缀和得到linkOffset
+    2. 排序后的下标就是link编号，每条link的流数量初始化为0
+    3. 在最后加上一条带宽为0的noLink，用来表示不存在的link
+*/
+void Network::buildLinks(std::vector<std::pair<std::pair<int, int>, float>> edges) {
+    // 1. 按(src, dst)排序，统计每个节点出发的link数量
+    std::sort(edges.begin(), edges.end());
+    linkNum = edges.size();
+    linkOffset = std::vector<int>(nodeNum + 1, 0);
+    for (auto& edge : edges) {
+        linkOffset[edge.first.first + 1]++;
+    }
+    for (int u = 0; u < nodeNum; u++) {
+        linkOffset[u + 1] += linkOffset[u];
+    }
+
+    // 2. 排序后的下标就是link编号
+    linkSrc.clear();
+    linkDst.clear();
+    linkBW.clear();
+    for (auto& edge : edges) {
+        linkSrc.push_back(edge.first.first);
+        linkDst.push_back(edge.first.second);
+        linkBW.push_back(edge.second);
+    }
+
+    // 3. noLink，带宽为0
+    noLink = linkNum;
+    linkSrc.push_back(-1);
+    linkDst.push_back(-1);
+    linkBW.push_back(0);
+    linkFlowNum = std::vector<int>(linkNum + 1, 0);
+    linkDirty = std::vector<char>(linkNum + 1, 0);
+}
+
+// 在u出发的link里查找终点为v的link，同一节点出发的link按终点排序，用二分查找
+int Network::linkId(int u, int v) {
+    if (u < 0 || u >= nodeNum) {
+        return noLink;
+    }
+    auto begin = linkDst.begin() + linkOffset[u];
+    auto end = linkDst.begin() + linkOffset[u + 1];
+    auto it = std::lower_bound(begin, end, v);
+    if (it == end || *it != v) {
+        return noLink;
+    }
+    return it - linkDst.begin();
+}
+
+// 把flow的path换算成link编号，path不变时只需要换算一次
+void Network::resolveLinks(Flow* flow) {
+    if (flow->links.size() + 1 == flow->path.size()) {
+        return;
+    }
+    flow->links.clear();
+    for (size_t i = 0; i + 1 < flow->path.size(); i++) {
+        flow->links.push_back(linkId(flow->path[i], flow->path[i + 1]));
+    }
+}
+
+/*
+目标：
+    求出src和dst（gpu或者leaf）之间的等价最短路径
+思路：
+    1. gpu先换算成它连接的leaf，路径的两端再加上gpu
+    2. leaf之间的路径集合由pathCache给出，与拓扑的类型无关
+       LeafSpine时第i条路径经过spine i；FatTree不同pod时第i条路径经过core i
+*/
+int Network::ecmpPathNum(int srcId, int dstId) {
+    int srcLeafId = srcId < gpuTotal ? gpuLeaf[srcId] : srcId;
+    int dstLeafId = dstId < gpuTotal ? gpuLeaf[dstId] : dstId;
+    return pathCache.pathNum(srcLeafId, dstLeafId);
+}
+
+std::vector<int> Network::nvlinkPath(int srcId, int dstId) {
+    return {srcId, nvswitchBase + srcId / gpuNum, dstId};
+}
+
+std::vector<int> Network::ecmpPath(int srcId, int dstId, int choice) {
+    // 1. gpu换算成leaf
+    int srcLeafId = srcId < gpuTotal ? gpuLeaf[srcId] : srcId;
+    int dstLeafId = dstId < gpuTotal ? gpuLeaf[dstId] : dstId;
+
+    // 2. 两端加上gpu
+    std::vector<int> path;
+    if (srcId < gpuTotal) {
+        path.push_back(srcId);
+    }
+    pathCache.appendPath(srcLeafId, dstLeafId, choice, path);
+    if (dstId < gpuTotal) {
+        path.push_back(dstId);
+    }
+    return path;
+}
+
 /*
 目标：
     实现ECMPRandom函数，根据gpuFlowManager将gpu里的flow随机分配到一个路径上
 思路：
-    1. 遍历gpuFlowManager所有的flow，确定flow属于哪个gpu，针对该flow的src，dst换算出在topo上的节点编号
-    2. 针对该gpu，随机选择一条从src到dst的可行路径，将flow分配到这条路径上。路径通常有5个节点，起点，三中间节点，终点
+    1. 遍历gpuFlowManager所有的flow（跳过经过NVSwitch的NVLink flow），确定flow属于哪个gpu，针对该flow的src，dst换算出在topo上的节点编号
+    2. 针对该gpu，随机选择一条从src到dst的等价最短路径，将flow分配到这条路径上，第i个flow的随机数来自自己的stream
+    3. 更新link上的流数量
 */
 
 void Network::ECMPRandom() {
-    for(auto& flow : gpuFlowManager) { // 注意这里的flow是指针类型
+    for (size_t i = 0; i < gpuFlowManager.size(); i++) {
+        Flow* flow = gpuFlowManager[i];
+        if (flow->linkClass == LINK_NVLINK) {
+            continue;
+        }
         // 1. 遍历gpuFlowManager所有的flow，确定flow所属的gpu，针对该flow的src，dst换算出在topo上的节点编号
-        int serverIdSrc = flow->src.first;
-        int gpuRankSrc = flow->src.second;
-
-        int serverIdDst = flow->dst.first;
-        int gpuRankDst = flow->dst.second;
-
-        int srcId = serverIdSrc * gpuNum + gpuRankSrc;
+        int srcId = flow->src.first * gpuNum + flow->src.second;
         flow->srcId = srcId;
-        int dstId = serverIdDst * gpuNum + gpuRankDst;
+        int dstId = flow->dst.first * gpuNum + flow->dst.second;
         flow->dstId = dstId;
-        // 2. 针对该gpu，随机选择一条从src到dst的可行路径，将flow分配到这条路径上。路径通常有5个节点，起点，三中间节点，终点
-        std::vector<int> path;
-        int srcLeafId = serverGroupNum * gpuNum + gpuRankSrc;
-        int spineId =  serverGroupNum * gpuNum+ leafNum + rand() % spineNum;
-        int dstLeafId = serverGroupNum * gpuNum + gpuRankDst;
-        
-        path = {srcId, srcLeafId, spineId, dstLeafId, dstId};
-
-        flow->setPath(path);
+        // 2. 随机选择一条等价最短路径
+        RandomStream rng = stream(RNG_ROUTING, i);
+        flow->setPath(ecmpPath(srcId, dstId, rng.below(ecmpPathNum(srcId, dstId))));
+
+        // 3. 更新link上的流数量
+        resolveLinks(flow);
+        for (int l : flow->links) {
+            linkFlowNum[l]++;
+        }
     }
 }
 
 
 /*
 目标：
-    实现Routing函数，根据gpuFlowManager将gpu里的flow分配到一个路径上
-    针对8server，每个server里8GPU，8Leaf，8Spine的网络拓扑
-    要求在分配路径时，每个链路上flow的数量不能超过2，<= 2
+    实现RoutingRandom函数，根据gpuFlowManager将gpu里的flow随机分配到一个路径上
+    要求在分配路径时，交换机之间每条link上gpu flow的数量不超过gpuFlowRoutingNum
 思路：
     1. 遍历gpuFlowManager所有的flow，确定flow所属的gpu，针对该flow的src，dst换算出在topo上的节点编号
-    2. 针对该gpu，选择一条从src到dst的可行路径，将flow分配到这条路径上。路径通常有5个节点，起点，三中间节点，终点
-    3. 要求在分配路径时，每个链路上flow的数量不能超过2，<= 2
+    2. 随机选择一条等价最短路径，如果交换机之间的link上流数量已经达到gpuFlowRoutingNum，重新选择，最多尝试100次
+       第i个flow的随机数来自自己的stream
+    3. 更新link上的流数量
 */
 void Network::RoutingRandom(int gpuFlowRoutingNum) {
-    // server * gpu = 8 * 8 = 64，leaf = 8，spine = 8
-    std::vector<int> spineIdList = {72, 73, 74, 75, 76, 77, 78, 79};
-    for(auto& flow : gpuFlowManager) { // 注意这里的flow是指针类型
+    for (size_t i = 0; i < gpuFlowManager.size(); i++) {
+        Flow* flow = gpuFlowManager[i];
+        if (flow->linkClass == LINK_NVLINK) {
+            continue;
+        }
         // 1. 遍历gpuFlowManager所有的flow，确定flow所属的gpu，针对该flow的src，dst换算出在topo上的节点编号
-        int serverIdSrc = flow->src.first;
-        int gpuRankSrc = flow->src.second;
-
-        int serverIdDst = flow->dst.first;
-        int gpuRankDst = flow->dst.second;
-
-        int srcId = serverIdSrc * gpuNum + gpuRankSrc;
+        int srcId = flow->src.first * gpuNum + flow->src.second;
         flow->srcId = srcId;
-        int dstId = serverIdDst * gpuNum + gpuRankDst;
+        int dstId = flow->dst.first * gpuNum + flow->dst.second;
         flow->dstId = dstId;
-        // 2. 针对该gpu，选择一条从src到dst的可行路径，将flow分配到这条路径上。路径通常有5个节点，起点，三中间节点，终点
-        std::vector<int> path;
-        int srcLeafId = serverGroupNum * gpuNum + gpuRankSrc;
-        int dstLeafId = serverGroupNum * gpuNum + gpuRankDst;
 
-        // 3. 要求在分配路径时，每个链路上flow的数量不能超过2，<= 1
-        int spineId;
+        // 2. 随机选择路径，gpu与leaf之间的link只有该gpu自己的flow，不需要检查
+        int pathNum = ecmpPathNum(srcId, dstId);
+        RandomStream rng = stream(RNG_ROUTING, i);
+        std::vector<int> path;
         int count = 0;
+        bool full;
         do {
             if(count > 100) {
                 break;
             }
             count++;
-            spineId = spineIdList[rand() % spineNum];
-        } while (topo[srcLeafId][spineId].first >= gpuFlowRoutingNum || topo[spineId][dstLeafId].first >= gpuFlowRoutingNum);
-        
-        
-        path = {srcId, srcLeafId, spineId, dstLeafId, dstId};
+            path = ecmpPath(srcId, dstId, rng.below(pathNum));
+            full = false;
+            for (size_t j = 1; j + 2 < path.size(); j++) {
+                if (linkFlowNum[linkId(path[j], path[j + 1])] >= gpuFlowRoutingNum) {
+                    full = true;
+                    break;
+                }
+            }
+        } while (full);
 
         flow->setPath(path);
 
-        // 更新topo里的流数量
-        for (int i = 0; i < path.size() - 1; i++) {
-            topo[path[i]][path[i + 1]].first++;
+        // 3. 更新link上的流数量
+        resolveLinks(flow);
+        for (int l : flow->links) {
+            linkFlowNum[l]++;
         }
     }
 }
 /*
-专门针对8server8gpu的固定路由
+固定路由，server i的flow经过第i条等价路径，NVLink的flow不经过交换机网络，跳过
 */
 void Network::Routing () {
-    // server * gpu = 8 * 8 = 64，leaf = 8，spine = 8
-    std::vector<int> spineIdList = {72, 73, 74, 75, 76, 77, 78, 79};
     for(auto& flow : gpuFlowManager) { // 注意这里的flow是指针类型
+        if (flow->linkClass == LINK_NVLINK) {
+            continue;
+        }
         // 1. 遍历gpuFlowManager所有的flow，确定flow所属的gpu，针对该flow的src，dst换算出在topo上的节点编号
         int serverIdSrc = flow->src.first;
-        int gpuRankSrc = flow->src.second;
-
-        int serverIdDst = flow->dst.first;
-        int gpuRankDst = flow->dst.second;
-
-        int srcId = serverIdSrc * gpuNum + gpuRankSrc;
+        int srcId = serverIdSrc * gpuNum + flow->src.second;
         flow->srcId = srcId;
-        int dstId = serverIdDst * gpuNum + gpuRankDst;
+        int dstId = flow->dst.first * gpuNum + flow->dst.second;
         flow->dstId = dstId;
-        // 2. 针对该gpu，选择一条从src到dst的可行路径，将flow分配到这条路径上。路径通常有5个节点，起点，三中间节点，终点
-        std::vector<int> path;
-        int srcLeafId = serverGroupNum * gpuNum + gpuRankSrc;
-        int dstLeafId = serverGroupNum * gpuNum + gpuRankDst;
 
-        // 3. 要求在分配路径时，每个链路上flow的数量不能超过2，<= 1
-        int spineId = spineIdList[serverIdSrc];
-        
-        path = {srcId, srcLeafId, spineId, dstLeafId, dstId};
+        // 2. 8server 8gpu时，server i的flow经过spine i
+        flow->setPath(ecmpPath(srcId, dstId, serverIdSrc));
 
-        flow->setPath(path);
+        // 3. 更新link上的流数量
+        resolveLinks(flow);
+        for (int l : flow->links) {
+            linkFlowNum[l]++;
+        }
+    }
+}
+
+// 正在发送的flow从旧path的流数量里移除，加入新path，两条path上的link都记为dirty，下一次updateRate重新计算rate
+void Network::rerouteFlow(Flow* flow, std::vector<int> path) {
+    if (flow->active) {
+        for (int l : flow->links) {
+            linkFlowNum[l]--;
+            if (!linkDirty[l]) {
+                linkDirty[l] = 1;
+                dirtyLinks.push_back(l);
+            }
+        }
+    }
+    flow->setPath(path);
+    resolveLinks(flow);
+    if (congestion) {
+        congestion->restart(flow->id);
+    }
+    if (flow->active) {
+        for (int l : flow->links) {
+            linkFlowNum[l]++;
+            if (!linkDirty[l]) {
+                linkDirty[l] = 1;
+                dirtyLinks.push_back(l);
+            }
+        }
+    }
+}
+
+/*
+目标：
+    实现RoutingAdaptive函数，按当前link上的流数量重新选择正在发送的gpu flow的等价路径
+思路：
+    1. 按gpuFlowManager的顺序依次处理正在发送的Net flow，前面的flow换路径之后立即更新流数量，后面的flow看到的是新的负载
+    2. 每条候选路径的估计rate为路径上 min(linkBW / 流数量)，不在当前路径上的link的流数量加上这个flow自己
+    3. 换路径需要migrationCost时间（重新建立连接，等待乱序的数据），这段时间不能发送：
+       只有 dataSize / 新rate + migrationCost < dataSize / 当前rate 时才换，换路径之后rate为0，停顿migrationCost时间，
+       停顿中不计入link上的流数量，停顿结束后由updateRate按新路径重新计入，发送的数据量不变
+    4. 估计rate相同时保留当前路径，返回换路径的flow数量
+*/
+int Network::RoutingAdaptive(float migrationCost) {
+    int migrations = 0;
+    for (auto& flow : gpuFlowManager) {
+        if (!flow->active || flow->dataSize() <= 0 || flow->linkClass == LINK_NVLINK) {
+            continue;
+        }
+
+        // 1. 2. 当前路径和候选路径的估计rate
+        float currentRate = pathRate(flow);
+        int pathNum = ecmpPathNum(flow->srcId, flow->dstId);
+        float bestRate = currentRate;
+        std::vector<int> bestPath;
+        for (int choice = 0; choice < pathNum; choice++) {
+            std::vector<int> path = ecmpPath(flow->srcId, flow->dstId, choice);
+            if (path == flow->path) {
+                continue;
+            }
+            float rate = FLOAT_MAX;
+            for (size_t i = 0; i + 1 < path.size(); i++) {
+                int l = linkId(path[i], path[i + 1]);
+                bool shared = std::find(flow->links.begin(), flow->links.end(), l) != flow->links.end();
+                rate = std::min(rate, linkBW[l] / (linkFlowNum[l] + (shared ? 0 : 1)));
+            }
+            if (rate > bestRate) {
+                bestRate = rate;
+                bestPath = path;
+            }
+        }
 
-        // 更新topo里的流数量
-        for (int i = 0; i < path.size() - 1; i++) {
-            topo[path[i]][path[i + 1]].first++;
+        // 3. 节省的时间超过换路径的代价时才换
+        float dataSize = flow->dataSize();
+        if (bestPath.empty() || dataSize / bestRate + migrationCost >= dataSize / currentRate) {
+            continue;
         }
+        rerouteFlow(flow, bestPath);
+        if (migrationCost > 0) {
+            if (flow->id >= (int)stallTime.size()) {
+                stallTime.resize(flowTable.size(), 0);
+            }
+            stallTime[flow->id] = migrationCost;
+            stalledNum++;
+            flow->setRate(0);
+        }
+        migrations++;
     }
+    return migrations;
+}
+
+/*
+目标：
+    实现countLinkFlows函数，统计每条link上的流数量
+思路：
+    1. 先将上一步里每条link上的流数量清零，以便当前时间片的更新，清零的代价只与link数量有关
+    2. 遍历两个流管理器gpuFlowManager和bgFlowManager里的所有flow，如果flow里的dataSize不为0，更新path上每条link的流数量  
+*/
+void Network::countLinkFlows() {
+    // 先将上一步里的流数量清零，以便当前时间片的更新
+    std::fill(linkFlowNum.begin(), linkFlowNum.end(), 0);
+
+    // 遍历两个流管理器gpuFlowManager和bgFlowManager里的所有flow，如果flow里的dataSize > 0，更新link上的流数量
+    // 同时记录每个flow是否已经计入流数量，供updateRate增量更新
+    for (auto& flow : gpuFlowManager) {
+        resolveLinks(flow);
+        flow->active = sending(flow);
+        if (flow->active) {
+            for (int l : flow->links) {
+                linkFlowNum[l]++;
+            }
+        }
+    }
+    for (auto& flow : bgFlowManager) {
+        resolveLinks(flow);
+        flow->active = sending(flow);
+        if (flow->active) {
+            for (int l : flow->links) {
+                linkFlowNum[l]++;
+            }
+        }
+    }
+}
+
+// 根据link上的流数量求出flow路径上的 min(linkBW / flowNum)
+float Network::pathRate(Flow* flow) {
+    float rate = FLOAT_MAX;
+    for (int l : flow->links) {
+        rate = std::min(rate, linkBW[l] / linkFlowNum[l]);
+    }
+    return rate;
 }
 
 /*
 目标：
     实现waterFilling函数，求出每个flow的rate
 思路：
-    1. 先将上一步里topo里的流数量清零，以便当前时间片的更新 
-    2. 遍历两个流管理器gpuFlowManager和bgFlowManager里的所有flow，如果flow里的dataSize不为0，更新topo里的流数量  
-    3. 求出gpuFlowManager里每个gpu的flow rate
+    1. 调用countLinkFlows更新每条link上的流数量
+    2. 求出gpuFlowManager里每个gpu的flow rate
         排除dataSize为0的flow，遍历每个flow的path，求出每个link上的流数量flowNum和带宽linkBW，
         rate = min(rate, linkBW / flowNum)
-    4. 求出bgFlowManager里每个干扰流的flow rate
+    3. 求出bgFlowManager里每个干扰流的flow rate
         排除dataSize为0的flow，遍历每个flow的path，求出每个link上的流数量flowNum和带宽linkBW，
         rate = min(rate, linkBW / flowNum) 
 */
 
 void Network::waterFilling() {
     
-    // 先将上一步里topo里的流数量清零，以便当前时间片的更新
-    for (int i = 0; i < topo.size(); i++) {
-        for (int j = 0; j < topo[i].size(); j++) {
-            topo[i][j].first = 0;
+    // 1. 更新link上的流数量
+    countLinkFlows();
+
+    // 2. 求出gpuFlowManager里每个gpu的flow rate，rate根据flow的path和link的带宽/流数量来计算
+    // 注意排除了空流的情况即dataSize = 0，以及换路径停顿中的flow
+    for (auto& flow : gpuFlowManager) {
+        if (flow->active) {
+            flow->setRate(pathRate(flow));
+        }
+    }
+
+    // 3. 求出bgFlowManager里每个干扰流的flow rate，rate根据flow的path和link的带宽/流数量来计算
+    for (auto& flow : bgFlowManager) {
+        if (flow->active) {
+            flow->setRate(pathRate(flow));
         }
     }
+}
+
+/*
+目标：
+    实现maxMinFairness函数，用progressive filling求出每个flow的max-min公平rate
+    waterFilling里被别的link限速的flow用不完它在当前link上的份额，这部分剩余带宽会浪费掉，
+    maxMinFairness会把剩余带宽继续分给同一link上的其他flow
+思路：
+    1. 调用countLinkFlows更新每条link上的流数量，作为每条link上未冻结flow的初始数量
+    2. 收集所有正在发送（countLinkFlows标记为active）的flow，按link编号记录每条link的剩余带宽和经过的flow
+    3. 每次取出 剩余带宽 / 未冻结flow数量 最小的link（瓶颈link），把该link上所有未冻结flow的rate设为这个份额并冻结，
+       同时从这些flow经过的每条link上减去该份额
+    4. 冻结flow只会让其他link的份额变大，所以用一个小根堆，过期的份额重新计算后再放回堆里
+*/
+void Network::maxMinFairness() {
+    // 1. 更新link上的流数量
+    countLinkFlows();
 
-    // 1. 遍历两个流管理器gpuFlowManager和bgFlowManager里的所有flow，如果flow里的dataSize > 0，更新topo里的流数量
+    // 2. 收集活跃的flow，按link编号记录剩余带宽和经过的flow
+    std::vector<Flow*> flows;
     for (auto& flow : gpuFlowManager) {
-        if (flow->dataSize > 0) {
-            for (int i = 0; i < flow->path.size() - 1; i++) {
-                topo[flow->path[i]][flow->path[i + 1]].first++;
-            }
+        if (flow->active) {
+            flows.push_back(flow);
         }
     }
     for (auto& flow : bgFlowManager) {
-        if (flow->dataSize > 0) {
-            for (int i = 0; i < flow->path.size() - 1; i++) {
-                topo[flow->path[i]][flow->path[i + 1]].first++;
-            }
+        if (flow->active) {
+            flows.push_back(flow);
         }
     }
 
-    // 2. 求出gpuFlowManager里每个gpu的flow rate，rate根据flow的path和topo里的topoBW/流数量来计算
-    // 注意排除了空流的情况即dataSize = 0
-    for (auto& flow : gpuFlowManager) {
-        if (flow->dataSize > 0) {
-            float rate = FLOAT_MAX;
-            std::vector<int> path = flow->path;
-            for (int i = 0; i < path.size() - 1; i++) {
-                int flowNum = topo[path[i]][path[i + 1]].first;
-                float linkBW = topo[path[i]][path[i + 1]].second;
-                rate = std::min(rate, linkBW / flowNum);
-            }
-            flow->setRate(rate);
+    std::vector<float> residual(linkBW); // 每条link的剩余带宽
+    std::vector<int> unfrozen(linkFlowNum); // 每条link上还没有冻结的flow数量
+    // 每条link上经过的flow，用CSR保存
+    std::vector<int> linkFlowOffset(linkNum + 2, 0);
+    for (int l = 0; l <= linkNum; l++) {
+        linkFlowOffset[l + 1] = linkFlowOffset[l] + linkFlowNum[l];
+    }
+    std::vector<int> linkFlows(linkFlowOffset[linkNum + 1]);
+    std::vector<int> fill(linkFlowOffset.begin(), linkFlowOffset.end() - 1);
+    for (size_t f = 0; f < flows.size(); f++) {
+        for (int l : flows[f]->links) {
+            linkFlows[fill[l]++] = f;
         }
     }
 
-    // 3. 求出bgFlowManager里每个干扰流的flow rate，rate根据flow的path和topo里的topoBW/流数量来计算
-    for (auto& flow : bgFlowManager) {
-        if (flow->dataSize > 0) {
-            float rate = FLOAT_MAX;
-            std::vector<int> path = flow->path;
-            for (int i = 0; i < path.size() - 1; i++) {
-                int flowNum = topo[path[i]][path[i + 1]].first;
-                float linkBW = topo[path[i]][path[i + 1]].second;
-                rate = std::min(rate, linkBW / flowNum);
+    // 3. progressive filling，每次冻结瓶颈link上的所有flow
+    std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, std::greater<std::pair<float, int>>> pq;
+    for (int l = 0; l <= linkNum; l++) {
+        if (unfrozen[l] > 0) {
+            pq.push({residual[l] / unfrozen[l], l});
+        }
+    }
+    std::vector<bool> frozen(flows.size(), false);
+    while (!pq.empty()) {
+        float share = pq.top().first;
+        int l = pq.top().second;
+        pq.pop();
+        if (unfrozen[l] == 0) {
+            continue;
+        }
+        // 4. 份额已经过期，重新计算后放回堆里
+        float current = residual[l] / unfrozen[l];
+        if (current != share) {
+            pq.push({current, l});
+            continue;
+        }
+        for (int i = linkFlowOffset[l]; i < linkFlowOffset[l + 1]; i++) {
+            int f = linkFlows[i];
+            if (frozen[f]) {
+                continue;
+            }
+            frozen[f] = true;
+            flows[f]->setRate(share);
+            for (int k : flows[f]->links) {
+                residual[k] = std::max(0.0f, residual[k] - share);
+                unfrozen[k]--;
             }
-            flow->setRate(rate);
+        }
+    }
+}
+
+// 根据rateAllocator调用对应的速率分配算法，有拥塞控制层时再由它给出rate
+void Network::allocateRate() {
+    if (rateAllocator == RateAllocator::MaxMin) {
+        maxMinFairness();
+    }
+    else {
+        waterFilling();
+    }
+    if (congestion) {
+        congestion->assign(*this);
+    }
+}
+
+bool Network::sending(Flow* flow) {
+    return flow->dataSize() > 0 && (stalledNum == 0 || flow->id >= (int)stallTime.size() || stallTime[flow->id] <= 0);
+}
+
+// 停顿结束时stallTime为0，stalledNum为还在停顿的flow数量
+void Network::advanceStall(float dt) {
+    if (stalledNum == 0) {
+        return;
+    }
+    stalledNum = 0;
+    for (float& stall : stallTime) {
+        if (stall > 0) {
+            stall = std::max(stall - dt, 0.0f);
+            stalledNum += stall > 0;
+        }
+    }
+}
+
+// flow开始发送（dataSize > 0并且不在停顿里）或者发送完、开始停顿时，更新它path上每条link的流数量，并把这些link记为dirty
+void Network::refreshLinkFlows(Flow* flow) {
+    bool active = sending(flow);
+    if (active == flow->active) {
+        return;
+    }
+    resolveLinks(flow);
+    flow->active = active;
+    for (int l : flow->links) {
+        linkFlowNum[l] += active ? 1 : -1;
+        if (!linkDirty[l]) {
+            linkDirty[l] = 1;
+            dirtyLinks.push_back(l);
         }
     }
 }
 
 /*
 目标：
-    实现dijkstra算法，该算法专门为网络中的周期性背景流量寻找一个路由路径
-    我不懂你的dijkstra的算法， 请明确一下，
-    你不需要用到topo[u][v].first，因为那是代表两节点之间链路上flow 的数量，
-    你只需要找到topo中srcId与dstId的最短路径，topo中任意两点的路径长度为topo[u][v].second，且为float。 
-    请重新修改你的dijkstra代码
+    实现updateRate函数，增量地维护每个flow的rate，代替每个时间片都调用一次waterFilling
+思路：
+    1. 遍历两个流管理器，只有flow开始发送或发送完时才更新link上的流数量，并记录流数量变化的dirtyLinks
+       rerouteFlow在两次updateRate之间换路径时记录的dirtyLinks也在这里一起处理
+    2. 没有dirtyLinks时，所有flow的rate都不变
+    3. waterFilling里flow的rate只取决于path上每条link的流数量，所以只重新计算经过dirtyLinks的flow
+    4. max-min的分配是全局的，任意一条link变化都可能影响所有flow，所以有dirtyLinks时重新调用maxMinFairness
+    5. 有拥塞控制层时，发送速率每个period都会变化，每次都由它重新给出所有flow的rate
+    最后清除dirty标记
 */
-std::vector<int> Network::dijkstra(int srcId, int dstId) {
-    int nodeNum = this->nodeNum;
-    std::vector<float> dist(nodeNum, std::numeric_limits<float>::max());
-    std::vector<int> prev(nodeNum, -1);
-    std::vector<bool> visited(nodeNum, false);
-    std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, std::greater<std::pair<float, int>>> pq;
-
-    dist[srcId] = 0;
-    pq.push({0, srcId});
+void Network::updateRate() {
+    // 1. 更新flow状态发生变化的link
+    for (auto& flow : gpuFlowManager) {
+        refreshLinkFlows(flow);
+    }
+    for (auto& flow : bgFlowManager) {
+        refreshLinkFlows(flow);
+    }
 
-    while (!pq.empty()) {
-        int u = pq.top().second;
-        pq.pop();
-        visited[u] = true;
-
-        for (int v = 0; v < nodeNum; v++) {
-            float weight = this->topo[u][v].second;
-            if (!visited[v] && dist[u] + weight < dist[v] && weight != 0) {
-                dist[v] = dist[u] + weight;
-                pq.push({dist[v], v});
-                prev[v] = u;
+    if (congestion) {
+        // 5. 拥塞控制层给出rate
+        congestion->assign(*this);
+    }
+    else if (dirtyLinks.empty()) {
+        // 2. 稳定状态下没有任何变化
+        return;
+    }
+    else if (rateAllocator == RateAllocator::MaxMin) {
+        // 4. max-min需要全局重新计算
+        maxMinFairness();
+    }
+    else {
+        // 3. 只重新计算经过dirtyLinks的flow
+        for (int m = 0; m < 2; m++) {
+            std::vector<Flow*>& flowManager = m == 0 ? gpuFlowManager : bgFlowManager;
+            for (auto& flow : flowManager) {
+                if (!flow->active) {
+                    continue;
+                }
+                for (int l : flow->links) {
+                    if (linkDirty[l]) {
+                        flow->setRate(pathRate(flow));
+                        break;
+                    }
+                }
             }
         }
     }
 
-    // Build the shortest path from src to dst
-    std::vector<int> path;
-    for (int at = dstId; at != -1; at = prev[at]) {
-        path.push_back(at);
+    for (int l : dirtyLinks) {
+        linkDirty[l] = 0;
     }
-    std::reverse(path.begin(), path.end());
+    dirtyLinks.clear();
+}
 
-    return path;
+/*
+目标：
+    求出src与dst之间的一条最短路径，用于给背景流量寻找路由路径
+思路：
+    所有link的跳数相同，最短路径就是pathCache里的第一条等价最短路径，不需要每次重新搜索
+*/
+std::vector<int> Network::dijkstra(int srcId, int dstId) {
+    return ecmpPath(srcId, dstId, 0);
+}
+
+void Network::setTickThreads(int threadNum) {
+    if (threadNum == 1) {
+        shardPool.reset();
+    }
+    else {
+        shardPool = std::make_unique<ShardPool>(threadNum);
+    }
 }
 
-// setp函数的实现，执行每个server里的step函数
+/*
+setp函数的实现，所有flow（gpu里的flow和背景流量）在flowTable里一次发送完unitTime的数据，再执行每个server里的step函数
+有shardPool时，每个分片处理一段连续的flow和一段连续的server，flow之间，server之间没有共享的状态，结果与串行相同
+*/
 void Network::step(float unitTime) {
+    if (shardPool) {
+        shardPool->run([this, unitTime](int shard) {
+            int flowNum = flowTable.size();
+            flowTable.drain(unitTime, shardPool->shardBegin(flowNum, shard), shardPool->shardBegin(flowNum, shard + 1));
+            int serverNum = serverGroup.size();
+            for (int s = shardPool->shardBegin(serverNum, shard); s < shardPool->shardBegin(serverNum, shard + 1); s++) {
+                serverGroup[s].step(unitTime);
+            }
+        });
+        return;
+    }
+    flowTable.drain(unitTime);
     for (auto& server : serverGroup) {
         server.step(unitTime);
     }
-    // 背景流量的step
-    for (auto& flow : bgFlowManager) {
-        if (flow->dataSize > 0) {
-            flow->dataSize -= flow->rate * unitTime;
-        }
-        else {
-            flow->dataSize = 0;
+}
+
+/*
+control函数的实现，执行每个server里的control函数，推进拥塞控制层的队列和发送速率，再更新rate
+server的control（滑动窗口决策，isWorkFinished）只修改自己gpu里的flow，可以按server分片并行；
+所有分片完成之后（第一个barrier）才在调用线程里运行共享的速率分配，下一次并行区域在它完成之后才开始（第二个barrier）
+*/
+void Network::control(float unitTime) {
+    if (shardPool) {
+        shardPool->run([this, unitTime](int shard) {
+            int serverNum = serverGroup.size();
+            for (int s = shardPool->shardBegin(serverNum, shard); s < shardPool->shardBegin(serverNum, shard + 1); s++) {
+                serverGroup[s].control(unitTime);
+            }
+        });
+    }
+    else {
+        for (auto& server : serverGroup) {
+            server.control(unitTime);
         }
     }
+    if (congestion) {
+        congestion->advance(*this, unitTime);
+    }
+    advanceStall(unitTime);
+    updateRate();
 }
 
-// control函数的实现，执行每个server里的control函数
-void Network::control(float unitTime) {
+/*
+目标：
+    实现nextEventTime函数，求出距离下一个事件的时间，仿真可以直接跳到该时刻，而不用每个unitTime都执行step和control
+思路：
+    1. 两个事件之间，所有flow的rate都不变，滑动窗口也不做决策，所以一次step(dt)与dt / unitTime次step(unitTime)等价
+    2. 事件包括：任意flow发送完（gpu里的flow和背景流量都在flowTable里，一次遍历求出），滑动窗口决策
+    3. 返回值是unitTime的整数倍，保证与逐unitTime步进的仿真结果一致
+    4. 背景流量的突发时刻由调用者根据bgFlowPeriod截断
+    5. 有拥塞控制层时，发送速率的更新时刻也是事件
+    6. 自适应路由换路径的flow停顿结束的时刻也是事件
+*/
+float Network::nextEventTime(float unitTime) {
     for (auto& server : serverGroup) {
-        server.control(unitTime);
+        if (server.windowPending()) {
+            return unitTime;
+        }
+    }
+    const float noEvent = FLOAT_MAX;
+    float eventTime = flowTable.nextDrainTime(unitTime);
+    if (congestion) {
+        eventTime = std::min(eventTime, congestion->nextUpdateTime(unitTime));
+    }
+    if (stalledNum > 0) {
+        for (float stall : stallTime) {
+            if (stall > 0) {
+                eventTime = std::min(eventTime, std::max(std::ceil(stall / unitTime), 1.0f) * unitTime);
+            }
+        }
+    }
+    // 没有任何事件时，退化为逐unitTime步进
+    if (eventTime == noEvent) {
+        return unitTime;
     }
-    waterFilling();
+    return eventTime;
 }
\ No newline at end of file
@@ -6,8 +6,27 @@
 #include <queue>
 #include <algorithm>
 #include <limits>
+#include <cmath>
+#include <memory>
+#include "congestion.h"
 #include "flow.h"
+#include "flow_table.h"
+#include "path_cache.h"
+#include "rng.h"
 #include "server.h"
+#include "thread_pool.h"
+
+// 网络拓扑的类型
+enum class TopoType {
+    LeafSpine, // 两层leaf/spine Clos，按rank分rail，rank r的gpu连接rail r的leaf
+    FatTree    // k-ary fat-tree，edge/aggregation/core三层，k = radix
+};
+
+// 速率分配算法，control()里根据rateAllocator选择
+enum class RateAllocator {
+    WaterFilling, // 每个flow的rate取路径上 linkBW / flowNum 的最小值
+    MaxMin        // progressive filling，瓶颈链路剩余的带宽会继续分给其他flow，得到max-min公平分配
+};
 
 class Network {
 public:
@@ -18,13 +37,48 @@ public:
     std::vector<std::vector<float>> NVLink;
     std::vector<Server> serverGroup;
 
-    // 邻接矩阵表示的网络拓扑，只包含Spine和Leaf，不包含Server
-    // pair表示两节点之间的链路，first表示link上流的数量flow num（初始化0），second表示link的带宽bandwidth
-    int leafNum = 8;
-    int spineNum = 8;
-    int nodeNum = 0;
+    // 拓扑参数，在init之前设置，默认值得到8个leaf，8个spine，与原来8server 8gpu的拓扑相同
+    TopoType topoType = TopoType::LeafSpine;
+    int radix = 16;             // 交换机的端口数，FatTree时为k
+    float oversubscription = 1; // leaf（edge）下行与上行带宽之比
     float topoBW = 10;
-    std::vector<std::vector<std::pair<int, float>>> topo; 
+
+    /*
+    生成的网络拓扑，节点编号依次为：gpu，leaf（FatTree的edge），aggregation（只有FatTree有），spine（FatTree的core），
+    每个server里的NVSwitch（只连接本server的gpu，不属于交换机网络）
+    gpu的编号为 serverId * gpuNum + rank，其他节点的编号范围由拓扑参数计算
+    */
+    int gpuTotal = 0;
+    int leafBase = 0;
+    int leafNum = 0;
+    int aggBase = 0;
+    int aggNum = 0;
+    int spineBase = 0;
+    int spineNum = 0;
+    int podSize = 0; // FatTree每个pod里edge和aggregation的数量，k / 2
+    int nvswitchBase = 0; // server s的NVSwitch编号为 nvswitchBase + s
+    int nodeNum = 0;
+    std::vector<int> gpuLeaf; // 每个gpu连接的leaf（edge）
+
+    // leaf之间等价最短路径的缓存，init时生成
+    PathCache pathCache;
+
+    /*
+    CSR（compressed sparse row）表示的网络拓扑，只保存存在的有向link，每条link有一个稠密的编号
+    linkOffset[u] ~ linkOffset[u + 1] - 1 是从节点u出发的link编号，同一个节点出发的link按终点排序
+    linkSrc[l]，linkDst[l]是link l的起点和终点，linkFlowNum[l]是link上流的数量，linkBW[l]是link的带宽
+    最后一个编号noLink表示不存在的link，带宽为0，与原来稠密矩阵里没有连接的两节点一致
+    */
+    int linkNum = 0;
+    int noLink = 0;
+    std::vector<int> linkOffset;
+    std::vector<int> linkSrc;
+    std::vector<int> linkDst;
+    std::vector<int> linkFlowNum;
+    std::vector<float> linkBW;
+
+    // 网络中所有flow（gpu里的flow和背景流量）的热字段
+    FlowTable flowTable;
 
     /*
     netflow管理器：记录网络中所有的flow，指针指向network里所有的flow，包括gpu里的flow和背景流量
@@ -32,23 +86,111 @@ public:
     std::vector<Flow*> gpuFlowManager;
     std::vector<Flow*> bgFlowManager;
 
+    // 速率分配算法，默认为waterFilling
+    RateAllocator rateAllocator = RateAllocator::WaterFilling;
+
+    // 本次updateRate里流数量发生变化的link，linkDirty[l]标记link l是否在dirtyLinks里
+    std::vector<int> dirtyLinks;
+    std::vector<char> linkDirty;
+
+    // 不为空时，step和control把server和flowTable分片到多个线程上并行运行，见setTickThreads
+    std::unique_ptr<ShardPool> shardPool;
+
+    // 自适应路由换路径之后还需要停顿的时间，下标为flow在FlowTable里的编号；停顿中的flow不发送，不计入link上的流数量
+    std::vector<float> stallTime;
+    int stalledNum = 0;
+
+    // 不为空时，flow的rate由拥塞控制层随时间调整，速率分配算法只维护link上的流数量，见congestion.h
+    std::unique_ptr<CongestionControl> congestion;
+
+    // 随机数的主种子，随机路由和背景流量的随机数都来自由它派生的独立stream，不使用全局状态
+    uint64_t masterSeed = 1;
+
     // Network构造函数
     Network();
 
-    // Network的初始化函数，生成网络拓扑，有8个leaf，8个spine，彼此是全互连的。
+    // Network的初始化函数，按topoType，radix，oversubscription生成网络拓扑，并创建serverGroup
     void init(int serverGroupNum, int gpuNum, float gpuDataSize, std::vector<std::vector<float>> NVLink, float topoBW);
 
+    // 生成leaf/spine Clos的link
+    void buildLeafSpine(std::vector<std::pair<std::pair<int, int>, float>>& edges);
+
+    // 生成k-ary fat-tree的link
+    void buildFatTree(std::vector<std::pair<std::pair<int, int>, float>>& edges);
+
+    // 生成每个server里gpu与NVSwitch之间的link，带宽为gpu的NVLink出口和入口带宽
+    void buildNVSwitch(std::vector<std::pair<std::pair<int, int>, float>>& edges);
+
+    // 根据(src, dst, bandwidth)列表生成CSR表示的网络拓扑
+    void buildLinks(std::vector<std::pair<std::pair<int, int>, float>> edges);
+
+    // 求出从u到v的link编号，不存在时返回noLink
+    int linkId(int u, int v);
+
+    // 把flow的path换算成link编号，保存在flow->links里
+    void resolveLinks(Flow* flow);
+
+    // 每个tick使用的线程数量，1为串行，0为硬件线程数
+    void setTickThreads(int threadNum);
+
+    // 重新设置主种子，相同的种子得到相同的路由和背景流量
+    void seed(uint64_t seed);
+
+    // 主种子下组件component的第index个随机数stream
+    RandomStream stream(uint64_t component, uint64_t index = 0);
+
+    // src和dst（gpu或者leaf）之间等价最短路径的数量
+    int ecmpPathNum(int srcId, int dstId);
+
+    // src和dst（gpu或者leaf）之间的第choice条等价最短路径，choice超过路径数量或者为负时取模
+    std::vector<int> ecmpPath(int srcId, int dstId, int choice);
+
+    // 同一个server里两个gpu之间经过NVSwitch的路径
+    std::vector<int> nvlinkPath(int srcId, int dstId);
+
+    // 随机选择一条等价最短路径，NVLink的flow路径在创建时确定，下面的路由都跳过
     void ECMPRandom();
 
-    // 用来测试的路由函数，针对8server，每个server里8GPU，8Leaf，8Spine的网络拓扑
+    // 随机路由，每条leaf-spine link上gpu flow的数量尽量不超过gpuFlowRoutingNum
     void RoutingRandom(int gpuFlowRoutingNum);
 
+    // 固定路由，server i的flow经过第i条等价路径，8server 8gpu时为spine i
     void Routing();
 
+    // 把flow换到path上，正在发送的flow同时更新新旧path上的流数量，并记录dirtyLinks，拥塞控制按新路径重新开始
+    void rerouteFlow(Flow* flow, std::vector<int> path);
+
+    // 自适应路由：按当前link上的流数量给正在发送的gpu flow重新选择等价路径，换路径的flow停顿migrationCost时间，返回换路径的flow数量
+    int RoutingAdaptive(float migrationCost);
+
+    // flow有数据并且不在换路径的停顿里，即正在发送
+    bool sending(Flow* flow);
+
+    // 停顿的时间减少dt，停顿结束的flow在下一次updateRate时重新计入link
+    void advanceStall(float dt);
+
+    // 统计每条link上正在发送的flow数量
+    void countLinkFlows();
+
+    // 根据link上的流数量求出flow路径上的 min(linkBW / flowNum)
+    float pathRate(Flow* flow);
+
     // water-filling算法用来求出leafs里每个flow的rate
     void waterFilling();
 
-    // dijkstra算法用来求出src与dst之间的最短路径
+    // progressive filling算法求出每个flow的max-min公平rate
+    void maxMinFairness();
+
+    // 根据rateAllocator调用对应的速率分配算法，重新统计所有link并计算所有flow的rate
+    void allocateRate();
+
+    // flow开始发送或发送完时，更新它path上的流数量，并记录dirtyLinks
+    void refreshLinkFlows(Flow* flow);
+
+    // 增量的速率分配，只有flow开始发送或发送完时才更新link的流数量，只重新计算经过dirtyLinks的flow
+    void updateRate();
+
+    // src与dst之间的一条最短路径，由pathCache给出
     std::vector<int> dijkstra(int srcId, int dstId);
 
     // step()函数，用来模拟网络中的每个节点的计算和通信
@@ -56,6 +198,9 @@ public:
 
     // control()函数，用来模拟网络中的每个节点的控制器
     void control(float unitTime);
+
+    // nextEventTime()函数，求出距离下一个事件的时间，用于事件驱动的时间推进
+    float nextEventTime(float unitTime);
 };
 
 #endif // NETWORK_H
\ No newline at end of file
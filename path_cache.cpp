@@ -0,0 +1,140 @@
+#include "path_cache.h"
+
+/*
+目标：
+    根据网络的CSR拓扑生成交换机之间的邻接表，并求出每个交换机到每个leaf的跳数
+思路：
+    1. 交换机的编号为 leafBase ~ nodeNum - 1，只保留两端都是交换机的link
+    2. 所有link都是双向的，从每个leaf b出发做一次BFS，得到每个交换机到b的跳数
+    3. 路径集合在查询时才生成，这里只清空索引
+*/
+void PathCache::build(int leafBase, int leafNum, int nodeNum, const std::vector<int>& linkOffset, const std::vector<int>& linkDst) {
+    this->leafBase = leafBase;
+    this->leafNum = leafNum;
+    this->switchNum = nodeNum - leafBase;
+
+    // 1. 交换机之间的邻接表
+    adjOffset.assign(switchNum + 1, 0);
+    adj.clear();
+    for (int u = 0; u < switchNum; u++) {
+        for (int l = linkOffset[leafBase + u]; l < linkOffset[leafBase + u + 1]; l++) {
+            if (linkDst[l] >= leafBase) {
+                adj.push_back(linkDst[l] - leafBase);
+            }
+        }
+        adjOffset[u + 1] = adj.size();
+    }
+
+    // 2. 从每个leaf出发的BFS
+    dist.assign((size_t)leafNum * switchNum, unreachable);
+    std::vector<int> queue(switchNum);
+    for (int b = 0; b < leafNum; b++) {
+        unsigned char* d = &dist[(size_t)b * switchNum];
+        int head = 0;
+        int tail = 0;
+        d[b] = 0;
+        queue[tail++] = b;
+        while (head < tail) {
+            int u = queue[head++];
+            for (int i = adjOffset[u]; i < adjOffset[u + 1]; i++) {
+                int v = adj[i];
+                if (d[v] == unreachable) {
+                    d[v] = d[u] + 1;
+                    queue[tail++] = v;
+                }
+            }
+        }
+    }
+
+    // 3. 清空路径集合
+    setOffset.assign((size_t)leafNum * leafNum, -1);
+    setCount.assign((size_t)leafNum * leafNum, 0);
+    setLength.assign((size_t)leafNum * leafNum, 0);
+    paths.clear();
+}
+
+/*
+目标：
+    生成leaf a到leaf b的所有等价最短路径
+思路：
+    1. 从a出发做DFS，每一步只走到b的跳数减少1的邻居，走到b时得到一条最短路径
+       只差一跳时下一个节点一定是b
+    2. 邻居按编号从小到大访问，第i条路径经过编号第i小的中间节点组合，与拓扑的结构一致（leaf/spine时第i条经过spine i）
+*/
+void PathCache::generate(int a, int b) {
+    size_t index = (size_t)a * leafNum + b;
+    const unsigned char* d = &dist[(size_t)b * switchNum];
+    setOffset[index] = paths.size();
+    if (d[a] == unreachable) {
+        return;
+    }
+    int length = d[a] + 1;
+    setLength[index] = length;
+
+    // 1. DFS，next[k]是路径上第k个节点下一个要尝试的邻居
+    std::vector<int> path(length);
+    std::vector<int> next(length);
+    int depth = 0;
+    path[0] = a;
+    next[0] = adjOffset[a];
+    while (depth >= 0) {
+        int u = path[depth];
+        if (u == b) {
+            for (int node : path) {
+                paths.push_back(leafBase + node);
+            }
+            setCount[index]++;
+            depth--;
+            continue;
+        }
+        // 2. 找下一个跳数减少1的邻居，只差一跳时下一个节点就是b，不需要扫描spine的所有邻居
+        bool advanced = false;
+        if (d[u] == 1) {
+            if (next[depth] != adjOffset[u + 1]) {
+                next[depth] = adjOffset[u + 1];
+                depth++;
+                path[depth] = b;
+                advanced = true;
+            }
+        }
+        while (!advanced && next[depth] < adjOffset[u + 1]) {
+            int v = adj[next[depth]++];
+            if (d[v] + 1 == d[u]) {
+                depth++;
+                path[depth] = v;
+                next[depth] = adjOffset[v];
+                advanced = true;
+                break;
+            }
+        }
+        if (!advanced) {
+            depth--;
+        }
+    }
+}
+
+int PathCache::pathNum(int srcLeafId, int dstLeafId) {
+    int a = srcLeafId - leafBase;
+    int b = dstLeafId - leafBase;
+    size_t index = (size_t)a * leafNum + b;
+    if (setOffset[index] == -1) {
+        generate(a, b);
+    }
+    return setCount[index];
+}
+
+void PathCache::appendPath(int srcLeafId, int dstLeafId, int choice, std::vector<int>& path) {
+    int count = pathNum(srcLeafId, dstLeafId);
+    if (count == 0) {
+        return;
+    }
+    size_t index = (size_t)(srcLeafId - leafBase) * leafNum + (dstLeafId - leafBase);
+    int length = setLength[index];
+    // 负的choice也取模到 0 ~ count - 1
+    int k = choice % count;
+    if (k < 0) {
+        k += count;
+    }
+    const int* begin = &paths[setOffset[index] + (size_t)k * length];
+    path.insert(path.end(), begin, begin + length);
+}
\ No newline at end of file
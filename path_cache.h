@@ -0,0 +1,48 @@
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <cstddef>
+#include <vector>
+
+/*
+leaf之间等价最短路径（ECMP）集合的缓存
+1. build时从网络的CSR拓扑中取出交换机之间的邻接表，对每个目的leaf做一次BFS，记录每个交换机到该leaf的跳数
+2. 某个leaf对的路径集合第一次被查询时，沿着跳数递减的link枚举出所有最短路径，连续存放在paths里，之后的查询都是O(1)
+3. 只保存被查询过的leaf对，大规模拓扑（几千个gpu，上百个leaf）也只需要很少的内存
+交换机的编号从leafBase开始连续，leaf在最前面，gpu不会作为中间节点
+*/
+class PathCache {
+public:
+    int leafBase = 0;
+    int leafNum = 0;
+    int switchNum = 0; // leaf，aggregation，spine的总数
+
+    // 交换机之间的邻接表（CSR），节点编号减去leafBase，邻居按编号从小到大排列
+    std::vector<int> adjOffset;
+    std::vector<int> adj;
+
+    // dist[b * switchNum + u]：交换机u到leaf b的跳数，不可达时为unreachable
+    static constexpr unsigned char unreachable = 255;
+    std::vector<unsigned char> dist;
+
+    // 每个leaf对(a, b)的路径集合：setOffset[a * leafNum + b]为paths里的起始位置，-1表示还没有生成
+    // 每条路径有setLength个节点，共setCount条
+    std::vector<int> setOffset;
+    std::vector<int> setCount;
+    std::vector<unsigned char> setLength;
+    std::vector<int> paths;
+
+    // 根据网络的CSR拓扑生成邻接表，并对每个目的leaf做BFS
+    void build(int leafBase, int leafNum, int nodeNum, const std::vector<int>& linkOffset, const std::vector<int>& linkDst);
+
+    // leaf a到leaf b的等价最短路径数量，不可达时为0
+    int pathNum(int srcLeafId, int dstLeafId);
+
+    // leaf a到leaf b的第choice条等价最短路径（choice对路径数量取模，可以为负），依次加到path后面
+    void appendPath(int srcLeafId, int dstLeafId, int choice, std::vector<int>& path);
+
+    // 生成leaf对的路径集合
+    void generate(int a, int b);
+};
+
+#endif // PATH_CACHE_H
\ No newline at end of file
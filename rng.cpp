@@ -0,0 +1,56 @@
+#include "rng.h"
+
+namespace {
+
+const uint64_t gamma = 0x9e3779b97f4a7c15ULL;
+
+uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+}
+
+/*
+目标：
+    由主种子，组件和index得到stream的key
+思路：
+    依次把主种子，组件，index混合进key，相邻的种子或index也会得到完全不同的key
+*/
+RandomStream::RandomStream(uint64_t seed, uint64_t component, uint64_t index) {
+    key = mix(seed + gamma);
+    key = mix(key ^ (component + gamma));
+    key = mix(key ^ (index + gamma));
+}
+
+uint32_t RandomStream::operator()() {
+    counter++;
+    return (uint32_t)(mix(key + counter * gamma) >> 32);
+}
+
+/*
+目标：
+    [0, n)之间的随机整数
+思路：
+    32位随机数乘以n取高32位（Lemire），不需要取模，偏差小于 n / 2^32
+*/
+uint32_t RandomStream::below(uint32_t n) {
+    return (uint32_t)(((uint64_t)(*this)() * n) >> 32);
+}
+
+double RandomStream::uniform() {
+    counter++;
+    return (mix(key + counter * gamma) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void RandomStream::discard(uint64_t n) {
+    counter += n;
+}
+
+uint64_t replicaSeed(uint64_t seed, int k) {
+    RandomStream rng(seed, RNG_REPLICA, k);
+    uint64_t high = rng();
+    uint64_t low = rng();
+    return high << 32 | low;
+}
\ No newline at end of file
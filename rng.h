@@ -0,0 +1,49 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// 各个组件的随机数stream编号，同一个主种子下不同编号的stream互相独立
+enum RandomComponent : uint64_t {
+    RNG_ROUTING = 1,      // gpu flow的随机路由，index为flow在gpuFlowManager里的位置
+    RNG_BG_FLOW_PLACE = 2, // 背景流量的src/dst leaf和路径，index为背景流量的编号
+    RNG_BG_FLOW_BURST = 3, // 背景流量每次突发的数据量，index为背景流量的编号
+    RNG_REPLICA = 4,       // 参数扫描里每个点重复运行时派生的种子，index为重复的编号
+    RNG_TRACE = 5,         // trace回放时每条记录的路径，index为记录的编号
+    RNG_CONGESTION = 6     // DCQCN每个flow是否收到CNP，index为flow在FlowTable里的编号
+};
+
+/*
+基于计数器的随机数stream
+1. 第n个随机数只由(主种子, 组件, index, n)决定：key由主种子和stream编号混合得到，第n个值为 mix(key + n * gamma)
+2. 不保存共享的状态，每个组件，每个背景流量都有自己的stream，取随机数的顺序不会影响其他stream
+3. 因此相同的主种子在任何线程数量，任何执行顺序下都得到完全相同的结果
+mix为splitmix64的输出函数
+*/
+class RandomStream {
+public:
+    uint64_t key = 0;
+    uint64_t counter = 0;
+
+    RandomStream() {}
+
+    // 主种子seed下组件component的第index个stream
+    RandomStream(uint64_t seed, uint64_t component, uint64_t index = 0);
+
+    // 下一个32位随机数
+    uint32_t operator()();
+
+    // [0, n)之间的随机整数，n为0时返回0
+    uint32_t below(uint32_t n);
+
+    // [0, 1)之间的随机数
+    double uniform();
+
+    // 跳到第n个随机数
+    void discard(uint64_t n);
+};
+
+// 主种子seed下第k次重复运行的种子，取RNG_REPLICA的第k个stream的前两个随机数，先取的为高32位
+uint64_t replicaSeed(uint64_t seed, int k);
+
+#endif // RNG_H
\ No newline at end of file
@@ -0,0 +1,631 @@
+#include "schedule.h"
+#include <algorithm>
+#include <iostream>
+
+// members在ready里的依赖，ready的下标为gpu编号
+static std::vector<std::vector<int>> gather(const std::vector<std::vector<int>>& ready, const std::vector<int>& members) {
+    std::vector<std::vector<int>> entry;
+    for (int gpu : members) {
+        entry.push_back(ready[gpu]);
+    }
+    return entry;
+}
+
+static void scatter(std::vector<std::vector<int>>& ready, const std::vector<int>& members, const std::vector<std::vector<int>>& done) {
+    for (size_t i = 0; i < members.size(); i++) {
+        ready[members[i]] = done[i];
+    }
+}
+
+/*
+目标：
+    展开config.collective或config.jobs的依赖图
+思路：
+    1. 没有config.jobs时为在所有server上运行一次config.collective的作业，阶段名字不加前缀；
+       作业的server超出范围时忽略，没有server时使用所有server
+    2. 作业的每次迭代展开一次addCollective，迭代的所有gpu完成时迭代完成；作业从startTime开始，
+       迭代完成之后经过computeTime开始下一次迭代，开始时间和计算时间都是延时传输
+    3. 有作业时阶段名字为 作业名.阶段名，同一个作业所有迭代的传输属于相同的阶段
+    4. 展开作业时设置channelJob，每个作业使用自己的channel
+*/
+void ScheduleCollective::init(Network* network, const SimConfig& config) {
+    this->network = network;
+    this->config = config;
+    opPartBegin.assign(1, 0);
+    int serverNum = network->serverGroup.size();
+    int gpuNum = network->gpuNum;
+
+    // 1. 作业和它们的server
+    jobs = config.jobs;
+    if (jobs.empty()) {
+        JobSpec job;
+        job.collective = config.collective;
+        jobs.push_back(job);
+    }
+    for (auto& job : jobs) {
+        std::vector<int> servers;
+        for (int s : job.servers) {
+            if (s < serverNum) {
+                servers.push_back(s);
+            }
+            else {
+                std::cerr << "job " << job.name << ": server " << s << " out of range, ignored" << std::endl;
+            }
+        }
+        if (servers.empty()) {
+            for (int s = 0; s < serverNum; s++) {
+                servers.push_back(s);
+            }
+        }
+        job.servers = servers;
+        if (job.gpuDataSize <= 0) {
+            job.gpuDataSize = config.gpuDataSize;
+        }
+    }
+
+    // 2. 展开每个作业的迭代
+    std::vector<std::vector<int>> ready(serverNum * gpuNum);
+    for (size_t j = 0; j < jobs.size(); j++) {
+        const JobSpec& job = jobs[j];
+        channelJob = j;
+        int stage = stages.size();
+        for (auto& name : collectiveStages(job.collective)) {
+            stages.push_back(config.jobs.empty() ? name : job.name + "." + name);
+        }
+        std::vector<int> entry;
+        if (job.startTime > 0) {
+            entry = {addDelay({}, job.startTime)};
+        }
+        jobIterationBegin.push_back(iterationFinishTime.size());
+        for (int k = 0; k < job.iterations; k++) {
+            for (int s : job.servers) {
+                for (int r = 0; r < gpuNum; r++) {
+                    ready[s * gpuNum + r] = entry;
+                }
+            }
+            addCollective(job.collective, job.servers, job.gpuDataSize, stage, ready);
+            std::vector<int> deps;
+            for (int s : job.servers) {
+                for (int r = 0; r < gpuNum; r++) {
+                    deps.insert(deps.end(), ready[s * gpuNum + r].begin(), ready[s * gpuNum + r].end());
+                }
+            }
+            std::sort(deps.begin(), deps.end());
+            deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+            int end = addDelay(deps, 0);
+            opIteration[end] = iterationFinishTime.size();
+            iterationFinishTime.push_back(0);
+            if (k + 1 < job.iterations) {
+                entry = {job.computeTime > 0 ? addDelay({end}, job.computeTime) : end};
+            }
+        }
+    }
+    jobIterationBegin.push_back(iterationFinishTime.size());
+    stepFinishTime.assign(stages.size(), 0);
+}
+
+std::vector<std::string> collectiveStages(Collective collective) {
+    switch (collective) {
+    case Collective::Ring:
+        return {"ring"};
+    case Collective::AllReduce:
+        return {"reduceScatter", "allGather"};
+    case Collective::HierarchicalRing:
+        return {"reduceScatter", "railReduceScatter", "railAllGather", "allGather"};
+    case Collective::HierarchicalTree:
+        return {"reduceScatter", "railReduce", "railBroadcast", "allGather"};
+    case Collective::DoubleBinaryTree:
+        return {"reduce", "broadcast"};
+    case Collective::AllToAllHierarchical:
+        return {"intraServer", "interServer"};
+    default:
+        return {"allToAll"};
+    }
+}
+
+/*
+目标：
+    在servers上展开一次collective的依赖图
+思路：
+    1. server内的ring从rank head开始，沿Server::ring排列；整个AllReduce的数据量 M = shard * gpuNum，S为servers的数量
+    2. Ring/AllReduce：与RingAllReduce相同，每个server里独立的ring，每个step每个gpu发送shard，Ring只有一个step，
+       AllReduce为reduce-scatter和all-gather共 2 * (gpuNum - 1) 个step；按ratio分配，不使用滑动窗口
+    3. HierarchicalRing/HierarchicalTree：
+       server内ring reduce-scatter，gpuNum - 1个step，每个step shard（M / gpuNum），之后rank r持有规约好的第r份数据
+       rail r（servers里rank r的gpu）在server之间对这一份数据做AllReduce：
+           ring时 2 * (S - 1) 个step，每个step shard / S；tree时为double binary tree
+       server内ring all-gather，gpuNum - 1个step，每个step shard
+       每个gpu自己的上一阶段完成就开始下一阶段，不需要等其他rail
+    4. DoubleBinaryTree：与NCCL的多个channel一样，数据分成gpuNum个channel，每个channel一对互补的树各负责一半，
+       channel c的第t棵树的server之间为binaryTree(S, t == 1)，经过每个server里rank (c + t * gpuNum / 2) % gpuNum的gpu，
+       server内从这个gpu开始沿ring连成一条链；每个rank的网卡是两棵树的入口，所有rail的网卡都被使用
+    5. all-to-all：N = S * gpuNum个gpu，每个gpu发给每个gpu的数据块 b = M / N = shard / S
+       AllToAll：所有gpu之间同时发送，AllToAllPairwise：每个阶段发给allToAllPeers个gpu
+       AllToAllHierarchical：server内gpu (s, r)把发给所有server里rank r'的数据（S * b）发给 (s, r')，
+       之后 (s, r')在rail r'上把server内汇总的发给 (s', r')的数据（gpuNum * b）发给 (s', r')，server之间的数据只经过rail；
+       每个gpu收到server内的数据之后就开始rail上的发送
+*/
+void ScheduleCollective::addCollective(Collective collective, const std::vector<int>& servers, float shard, int stage,
+                                       std::vector<std::vector<int>>& ready) {
+    int serverNum = servers.size();
+    int gpuNum = network->gpuNum;
+
+    // 1. server内的ring，作业里所有gpu按server，rank的顺序排列
+    auto serverRing = [&](int s, int head) {
+        std::vector<int> members;
+        int rank = head;
+        for (int j = 0; j < gpuNum; j++) {
+            members.push_back(s * gpuNum + rank);
+            rank = network->serverGroup[s].ring[rank];
+        }
+        return members;
+    };
+    auto rail = [&](int r) {
+        std::vector<int> members;
+        for (int s : servers) {
+            members.push_back(s * gpuNum + r);
+        }
+        return members;
+    };
+    std::vector<int> members;
+    for (int s : servers) {
+        for (int r = 0; r < gpuNum; r++) {
+            members.push_back(s * gpuNum + r);
+        }
+    }
+
+    // 2. server内的ring AllReduce
+    if (collective == Collective::Ring || collective == Collective::AllReduce) {
+        std::vector<int> steps = {stage};
+        if (collective == Collective::AllReduce) {
+            steps.assign(gpuNum - 1, stage);
+            steps.resize(2 * (gpuNum - 1), stage + 1);
+        }
+        for (int s : servers) {
+            std::vector<int> ring = serverRing(s, 0);
+            scatter(ready, ring, addRing(ring, shard, steps, gather(ready, ring)));
+        }
+    }
+    // 3. 层次化的AllReduce
+    else if (collective == Collective::HierarchicalRing || collective == Collective::HierarchicalTree) {
+        std::vector<int> intraSteps(gpuNum - 1, stage);
+        for (int s : servers) {
+            std::vector<int> ring = serverRing(s, 0);
+            scatter(ready, ring, addRing(ring, shard, intraSteps, gather(ready, ring)));
+        }
+        std::vector<int> railSteps(serverNum - 1, stage + 1);
+        railSteps.resize(2 * (serverNum - 1), stage + 2);
+        for (int r = 0; r < gpuNum; r++) {
+            std::vector<int> railMembers = rail(r);
+            if (collective == Collective::HierarchicalRing) {
+                scatter(ready, railMembers, addRing(railMembers, shard / serverNum, railSteps, gather(ready, railMembers)));
+            }
+            else {
+                scatter(ready, railMembers, addDoubleTree(railMembers, shard, stage + 1, stage + 2, gather(ready, railMembers)));
+            }
+        }
+        intraSteps.assign(gpuNum - 1, stage + 3);
+        for (int s : servers) {
+            std::vector<int> ring = serverRing(s, 0);
+            scatter(ready, ring, addRing(ring, shard, intraSteps, gather(ready, ring)));
+        }
+    }
+    // 4. double binary tree，parent为members里的下标
+    else if (collective == Collective::DoubleBinaryTree) {
+        std::vector<std::vector<int>> entry = gather(ready, members);
+        std::vector<std::vector<int>> done(members.size());
+        for (int c = 0; c < gpuNum; c++) {
+            for (int t = 0; t < 2; t++) {
+                int head = (c + t * gpuNum / 2) % gpuNum;
+                std::vector<int> serverParent = binaryTree(serverNum, t == 1);
+                std::vector<int> parent(members.size(), -1);
+                for (int k = 0; k < serverNum; k++) {
+                    std::vector<int> chain = serverRing(servers[k], head);
+                    parent[k * gpuNum + head] = serverParent[k] < 0 ? -1 : serverParent[k] * gpuNum + head;
+                    for (int j = 1; j < gpuNum; j++) {
+                        parent[k * gpuNum + chain[j] % gpuNum] = k * gpuNum + chain[j - 1] % gpuNum;
+                    }
+                }
+                std::vector<std::vector<int>> tree = addTree(members, parent, shard / 2, config.treeChunks, stage, stage + 1, entry);
+                for (size_t i = 0; i < members.size(); i++) {
+                    done[i].insert(done[i].end(), tree[i].begin(), tree[i].end());
+                }
+            }
+        }
+        scatter(ready, members, done);
+    }
+    // 5. all-to-all
+    else {
+        float block = shard / serverNum;
+        if (collective == Collective::AllToAllHierarchical) {
+            for (int k = 0; k < serverNum; k++) {
+                std::vector<int> server(members.begin() + k * gpuNum, members.begin() + (k + 1) * gpuNum);
+                scatter(ready, server, addAllToAll(server, block * serverNum, gpuNum, stage, gather(ready, server)));
+            }
+            for (int r = 0; r < gpuNum; r++) {
+                std::vector<int> railMembers = rail(r);
+                scatter(ready, railMembers, addAllToAll(railMembers, block * gpuNum, serverNum, stage + 1, gather(ready, railMembers)));
+            }
+        }
+        else {
+            int peers = collective == Collective::AllToAll ? (int)members.size() : config.allToAllPeers;
+            scatter(ready, members, addAllToAll(members, block, peers, stage, gather(ready, members)));
+        }
+    }
+}
+
+int ScheduleCollective::channel(int src, int dst, int linkClass) {
+    std::tuple<int, int, int, int> key(channelJob, src, dst, linkClass);
+    auto it = channelOf.find(key);
+    if (it != channelOf.end()) {
+        return it->second;
+    }
+    int gpuNum = network->gpuNum;
+    int c = flows.size();
+    flows.emplace_back(&network->flowTable);
+    Flow& flow = flows.back();
+    flow.init({src / gpuNum, src % gpuNum}, {dst / gpuNum, dst % gpuNum}, 0, linkClass);
+    flow.srcId = src;
+    flow.dstId = dst;
+    if (linkClass == LINK_NVLINK) {
+        flow.setPath(network->nvlinkPath(src, dst));
+    }
+    network->gpuFlowManager.push_back(&flow);
+    channelOf[key] = c;
+    channelQueue.emplace_back();
+    channelHead.push_back(0);
+    channelPart.push_back(-1);
+    return c;
+}
+
+// 同一个server里的传输按ratio分给NVLink和Net，ratio为1时只有NVLink，为0时只有Net
+int ScheduleCollective::addTransfer(int src, int dst, float size, int stage, const std::vector<int>& deps) {
+    int op = opNext.size();
+    opNext.emplace_back();
+    opWaiting.push_back(deps.size());
+    opStage.push_back(stage);
+    opDelay.push_back(config.transferLatency);
+    opIteration.push_back(-1);
+    for (int dep : deps) {
+        opNext[dep].push_back(op);
+    }
+
+    auto addPart = [&](int c, float partDataSize) {
+        partOp.push_back(op);
+        partChannel.push_back(c);
+        partSize.push_back(partDataSize);
+        partStart.push_back(0);
+    };
+    if (src / network->gpuNum == dst / network->gpuNum) {
+        float ratio = std::min(std::max(config.ratio, 0.0f), 1.0f);
+        if (ratio > 0) {
+            addPart(channel(src, dst, LINK_NVLINK), size * ratio);
+        }
+        if (ratio < 1) {
+            addPart(channel(src, dst, LINK_NET), size * (1 - ratio));
+        }
+    }
+    else {
+        addPart(channel(src, dst, LINK_NET), size);
+    }
+    opPartsLeft.push_back(partOp.size() - opPartBegin.back());
+    opPartBegin.push_back(partOp.size());
+    return op;
+}
+
+int ScheduleCollective::addDelay(const std::vector<int>& deps, float delay) {
+    int op = opNext.size();
+    opNext.emplace_back();
+    opWaiting.push_back(deps.size());
+    opStage.push_back(-1);
+    opDelay.push_back(delay);
+    opIteration.push_back(-1);
+    for (int dep : deps) {
+        opNext[dep].push_back(op);
+    }
+    opPartsLeft.push_back(0);
+    opPartBegin.push_back(partOp.size());
+    return op;
+}
+
+/*
+目标：
+    在ring上按step展开传输
+思路：
+    第i个成员的step k发送step k - 1收到的数据，依赖自己的step k - 1（channel按顺序发送）和前一个成员的step k - 1（收到数据）
+    最后一个step之后，第i个成员发送完并且收到了前一个成员的数据
+*/
+std::vector<std::vector<int>> ScheduleCollective::addRing(const std::vector<int>& members, float size, const std::vector<int>& stepStage,
+                                                         const std::vector<std::vector<int>>& entry) {
+    int n = members.size();
+    if (n < 2 || stepStage.empty()) {
+        return entry;
+    }
+    std::vector<int> last(n);
+    for (size_t k = 0; k < stepStage.size(); k++) {
+        std::vector<int> current(n);
+        for (int i = 0; i < n; i++) {
+            std::vector<int> deps = k == 0 ? entry[i] : std::vector<int>{last[i], last[(i + n - 1) % n]};
+            current[i] = addTransfer(members[i], members[(i + 1) % n], size, stepStage[k], deps);
+        }
+        last = current;
+    }
+    std::vector<std::vector<int>> done(n);
+    for (int i = 0; i < n; i++) {
+        done[i] = {last[i], last[(i + n - 1) % n]};
+    }
+    return done;
+}
+
+/*
+目标：
+    在一棵树上展开流水线的reduce和broadcast
+思路：
+    1. 从root开始BFS得到节点的顺序，reduce按相反的顺序展开，子节点的传输先于父节点创建
+    2. chunk k：节点收到所有子节点的chunk k之后发给父节点；root收到所有子节点的chunk k之后开始broadcast，
+       节点收到父节点的chunk k之后转发给每个子节点
+    3. 同一个channel上的chunk按顺序发送，收到最后一个chunk时已经收到所有chunk：
+       root等待每个子节点发来的最后一个chunk，其他节点等待父节点发来的最后一个chunk
+*/
+std::vector<std::vector<int>> ScheduleCollective::addTree(const std::vector<int>& members, const std::vector<int>& parent, float size,
+                                                         int chunkNum, int reduceStage, int broadcastStage,
+                                                         const std::vector<std::vector<int>>& entry) {
+    int n = members.size();
+    if (n < 2) {
+        return entry;
+    }
+    // 1. BFS的顺序
+    std::vector<std::vector<int>> children(n);
+    int root = 0;
+    for (int i = 0; i < n; i++) {
+        if (parent[i] < 0) {
+            root = i;
+        }
+        else {
+            children[parent[i]].push_back(i);
+        }
+    }
+    std::vector<int> order = {root};
+    for (size_t j = 0; j < order.size(); j++) {
+        for (int child : children[order[j]]) {
+            order.push_back(child);
+        }
+    }
+
+    // 2. 每个chunk的reduce和broadcast
+    float chunk = size / chunkNum;
+    std::vector<int> up(n, -1);
+    std::vector<int> down(n, -1);
+    std::vector<int> rootReady;
+    for (int k = 0; k < chunkNum; k++) {
+        for (int j = n - 1; j > 0; j--) {
+            int i = order[j];
+            std::vector<int> deps = entry[i];
+            for (int child : children[i]) {
+                deps.push_back(up[child]);
+            }
+            up[i] = addTransfer(members[i], members[parent[i]], chunk, reduceStage, deps);
+        }
+        rootReady = entry[root];
+        for (int child : children[root]) {
+            rootReady.push_back(up[child]);
+        }
+        for (int j = 1; j < n; j++) {
+            int i = order[j];
+            std::vector<int> deps = parent[i] == root ? rootReady : std::vector<int>{down[parent[i]]};
+            down[i] = addTransfer(members[parent[i]], members[i], chunk, broadcastStage, deps);
+        }
+    }
+
+    // 3. 收到最后一个chunk
+    std::vector<std::vector<int>> done(n);
+    for (int i = 0; i < n; i++) {
+        done[i] = i == root ? rootReady : std::vector<int>{down[i]};
+    }
+    return done;
+}
+
+// 两棵树各负责一半的数据，成员在两棵树上都收到结果时完成
+std::vector<std::vector<int>> ScheduleCollective::addDoubleTree(const std::vector<int>& members, float size, int reduceStage,
+                                                               int broadcastStage, const std::vector<std::vector<int>>& entry) {
+    int n = members.size();
+    std::vector<std::vector<int>> first = addTree(members, binaryTree(n, false), size / 2, config.treeChunks, reduceStage, broadcastStage, entry);
+    std::vector<std::vector<int>> second = addTree(members, binaryTree(n, true), size / 2, config.treeChunks, reduceStage, broadcastStage, entry);
+    for (int i = 0; i < n; i++) {
+        first[i].insert(first[i].end(), second[i].begin(), second[i].end());
+    }
+    return first;
+}
+
+/*
+目标：
+    展开分阶段的all-to-all
+思路：
+    1. 第i个成员在第k个阶段发给偏移为 k * peers + 1 ~ (k + 1) * peers 的成员 (i + offset) % n，每个阶段每个成员收到的也是peers个
+    2. 第一个阶段依赖entry，之后的阶段依赖自己上一个阶段的发送和接收，与一次只和少数对端交换数据的实现相同
+    3. 成员收到其他所有成员的数据时完成
+*/
+std::vector<std::vector<int>> ScheduleCollective::addAllToAll(const std::vector<int>& members, float size, int peers, int stage,
+                                                             const std::vector<std::vector<int>>& entry) {
+    int n = members.size();
+    if (n < 2) {
+        return entry;
+    }
+    peers = std::min(std::max(peers, 1), n - 1);
+    std::vector<std::vector<int>> last(n);
+    std::vector<std::vector<int>> done(n);
+    for (int first = 1; first < n; first += peers) {
+        std::vector<std::vector<int>> current(n);
+        for (int i = 0; i < n; i++) {
+            std::vector<int> deps = first == 1 ? entry[i] : last[i];
+            for (int offset = first; offset < std::min(first + peers, n); offset++) {
+                int j = (i + offset) % n;
+                int op = addTransfer(members[i], members[j], size, stage, deps);
+                current[i].push_back(op);
+                current[j].push_back(op);
+                done[j].push_back(op);
+            }
+        }
+        last = current;
+    }
+    return done;
+}
+
+/*
+目标：
+    与NCCL相同的double binary tree
+思路：
+    1. 第一棵树：节点v的最低位的1为bit，父节点为 (v ^ bit) | (bit << 1)，超出范围时为 v ^ bit；节点0为root，只有一个子节点
+       叶子都是奇数编号的节点，内部节点都是偶数编号的节点
+    2. 第二棵树：n为偶数时把编号镜像为 n - 1 - v，n为奇数时平移为 v - 1，第一棵树的叶子大多是第二棵树的内部节点，
+       每个节点在两棵树上的发送和接收量加起来接近平衡
+*/
+std::vector<int> binaryTree(int n, bool second) {
+    auto relabel = [n, second](int v, bool forward) {
+        if (!second) {
+            return v;
+        }
+        if (n % 2 == 0) {
+            return n - 1 - v;
+        }
+        return forward ? (v - 1 + n) % n : (v + 1) % n;
+    };
+    std::vector<int> parent(n, -1);
+    for (int rank = 0; rank < n; rank++) {
+        int v = relabel(rank, true);
+        if (v == 0) {
+            continue;
+        }
+        int bit = 1;
+        while (bit < n && !(bit & v)) {
+            bit <<= 1;
+        }
+        int up = (v ^ bit) | (bit << 1);
+        if (up >= n) {
+            up = v ^ bit;
+        }
+        parent[rank] = relabel(up, false);
+    }
+    return parent;
+}
+
+void ScheduleCollective::enqueue(int op, float time) {
+    if (opPartBegin[op] == opPartBegin[op + 1]) {
+        complete(op, time);
+        return;
+    }
+    for (int p = opPartBegin[op]; p < opPartBegin[op + 1]; p++) {
+        channelQueue[partChannel[p]].push_back(p);
+    }
+}
+
+void ScheduleCollective::ready(int op, float time) {
+    if (opDelay[op] > 0) {
+        pending.push({time + opDelay[op], op});
+    }
+    else {
+        enqueue(op, time);
+    }
+}
+
+void ScheduleCollective::complete(int op, float time) {
+    doneOps++;
+    if (opStage[op] >= 0) {
+        stepFinishTime[opStage[op]] = std::max(stepFinishTime[opStage[op]], time);
+    }
+    if (opIteration[op] >= 0) {
+        iterationFinishTime[opIteration[op]] = time;
+    }
+    for (int next : opNext[op]) {
+        if (--opWaiting[next] == 0) {
+            ready(next, time);
+        }
+    }
+}
+
+void ScheduleCollective::start() {
+    for (size_t op = 0; op < opNext.size(); op++) {
+        if (opWaiting[op] == 0) {
+            ready(op, 0);
+        }
+    }
+    progress(0);
+}
+
+float ScheduleCollective::nextReadyTime() {
+    return pending.empty() ? FLOAT_MAX : pending.top().time;
+}
+
+/*
+目标：
+    记录发送完的part，空闲的channel开始下一个part
+思路：
+    1. channel的flow发送完时，part完成，传输的所有part都完成时传输完成，依赖它的传输可能变为就绪
+    2. 等待时延到期的传输加入队列
+    3. 先处理所有完成的part，再让空闲的channel取队列里的下一个part，同一时刻就绪的传输不需要等下一个tick
+*/
+bool ScheduleCollective::progress(float time) {
+    // 1. 发送完的part
+    const float epsilon = 1e-5;
+    for (size_t c = 0; c < flows.size(); c++) {
+        int p = channelPart[c];
+        if (p < 0 || flows[c].dataSize() > epsilon) {
+            continue;
+        }
+        channelPart[c] = -1;
+        int op = partOp[p];
+        if (fctStats) {
+            fctStats->add(flows[c].linkClass, opStage[op], flows[c].completionTime() - partStart[p]);
+        }
+        if (--opPartsLeft[op] == 0) {
+            complete(op, time);
+        }
+    }
+
+    // 2. 时延到期的传输
+    while (!pending.empty() && pending.top().time <= time) {
+        int op = pending.top().op;
+        pending.pop();
+        enqueue(op, time);
+    }
+
+    // 3. 空闲的channel开始下一个part
+    bool started = false;
+    for (size_t c = 0; c < flows.size(); c++) {
+        if (channelPart[c] >= 0 || channelHead[c] == (int)channelQueue[c].size()) {
+            continue;
+        }
+        int p = channelQueue[c][channelHead[c]++];
+        channelPart[c] = p;
+        partStart[p] = flows[c].completionTime();
+        flows[c].dataSize() = partSize[p];
+        started = true;
+    }
+    return started;
+}
+
+bool ScheduleCollective::finished() {
+    return doneOps == (int)opNext.size();
+}
+
+std::vector<std::string> ScheduleCollective::stageNames() {
+    return stages;
+}
+
+// 第一次迭代从startTime开始，之后的迭代从上一次迭代完成之后经过computeTime开始
+std::vector<JobResult> ScheduleCollective::jobResults() {
+    std::vector<JobResult> results;
+    for (size_t j = 0; j < jobs.size() && !config.jobs.empty(); j++) {
+        JobResult result;
+        result.name = jobs[j].name;
+        float begin = jobs[j].startTime;
+        for (int k = jobIterationBegin[j]; k < jobIterationBegin[j + 1]; k++) {
+            result.finishTime.push_back(iterationFinishTime[k]);
+            result.iterationTime.push_back(iterationFinishTime[k] - begin);
+            result.meanIterationTime += result.iterationTime.back() / jobs[j].iterations;
+            begin = iterationFinishTime[k] + jobs[j].computeTime;
+        }
+        results.push_back(result);
+    }
+    return results;
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <deque>
+#include <map>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "network.h"
+#include "simulation.h"
+#include "stats.h"
+
+/*
+按传输依赖图调度的集合通信引擎，用于层次化和树形的AllReduce以及all-to-all（见SimConfig::collective）
+1. 算法在init时展开成一张传输的依赖图：每个传输是从一个gpu发给另一个gpu的一段数据，所有依赖的传输完成之后才能开始
+2. 每个作业的每对(src gpu, dst gpu, 传输类型)是一个channel，对应一个flow；同一个channel上的传输按就绪的顺序依次发送
+3. 依赖都完成之后再等待transferLatency才开始发送，表示每个传输固定的启动开销
+4. 同一个server里的传输按ratio分给NVLink和经过网络的Net两个channel（与ring里的Ratio相同），两部分都发送完时传输完成；
+   不同server之间的传输只有Net；Net的channel加入gpuFlowManager，与ring的flow一样路由，分配rate和拥塞控制；
+   NVLink的channel经过server的NVSwitch（Network::nvlinkPath），也加入gpuFlowManager，同一个gpu的所有NVLink channel分享它的NVLink出口和入口带宽
+5. 整个AllReduce的数据量为 gpuDataSize * gpuNum，与ring AllReduce每个step每个gpu发送gpuDataSize一致；
+   all-to-all时每个gpu发送的数据量也是 gpuDataSize * gpuNum，平均分给所有gpu（包括自己，发给自己的不需要传输）
+6. config.jobs不为空时每个作业在自己的server上展开自己的集合通信，迭代的次数展开成依赖图里连续的几份，
+   作业的开始时间和迭代之间的计算时间是没有part的延时传输；不同作业的channel是不同的flow，server重叠时也不会排在同一个队列里，
+   而是在同一个Network里共享link和rate分配
+
+gpu的编号为 serverId * gpuNum + rank，与Network里topo的编号相同
+*/
+class ScheduleCollective {
+public:
+    // 依赖已经完成，等待transferLatency之后才加入channel队列的传输
+    struct Pending {
+        float time;
+        int op;
+        bool operator>(const Pending& other) const { return time > other.time || (time == other.time && op > other.op); }
+    };
+
+    Network* network = nullptr;
+    SimConfig config;
+
+    // 传输：依赖它的传输，还没有完成的依赖数量，还没有发送完的part数量，所属的阶段（延时传输为-1），
+    // 依赖完成之后等待的时延，完成时记录的迭代（-1为不记录）
+    // 传输o的part为 opPartBegin[o] ~ opPartBegin[o + 1] - 1，没有part的延时传输在时延到期时完成
+    std::vector<std::vector<int>> opNext;
+    std::vector<int> opWaiting;
+    std::vector<int> opPartsLeft;
+    std::vector<int> opStage;
+    std::vector<float> opDelay;
+    std::vector<int> opIteration;
+    std::vector<int> opPartBegin;
+    int doneOps = 0;
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> pending;
+
+    // part：一个传输在一个channel上发送的部分，partStart为开始发送时channel flow的completionTime
+    std::vector<int> partOp;
+    std::vector<int> partChannel;
+    std::vector<float> partSize;
+    std::vector<float> partStart;
+
+    // channel：flow，等待发送的part队列（channelHead之前的已经取走），正在发送的part（-1为空闲）
+    std::deque<Flow> flows;
+    // (作业, src gpu, dst gpu, linkClass) -> channel，channelJob为展开中的作业
+    std::map<std::tuple<int, int, int, int>, int> channelOf;
+    int channelJob = 0;
+    std::vector<std::vector<int>> channelQueue;
+    std::vector<int> channelHead;
+    std::vector<int> channelPart;
+
+    // 阶段的名字，每个阶段最后一个传输完成的时间
+    std::vector<std::string> stages;
+    std::vector<float> stepFinishTime;
+
+    // 展开的作业（没有config.jobs时为运行config.collective的一个作业），作业j的迭代为 jobIterationBegin[j] ~ jobIterationBegin[j + 1] - 1，
+    // 每次迭代最后一个gpu完成的时间
+    std::vector<JobSpec> jobs;
+    std::vector<int> jobIterationBegin;
+    std::vector<float> iterationFinishTime;
+
+    // 不为空时，每个part发送完时把它的完成时间加到fctStats里，kind为channel的linkClass，stage为传输的阶段
+    FctStats* fctStats = nullptr;
+
+    // 展开config.collective或config.jobs的依赖图，创建所有channel的flow；在路由之前调用，Net的channel由路由统一选择路径，NVLink的channel在创建时确定路径
+    void init(Network* network, const SimConfig& config);
+
+    // 作业的迭代时间，没有config.jobs时为空
+    std::vector<JobResult> jobResults();
+
+    // 开始所有没有依赖的传输
+    void start();
+
+    // 在control之后调用：记录发送完的part和完成的传输，空闲的channel开始下一个part；有part开始发送时返回true
+    bool progress(float time);
+
+    // 所有传输都完成了
+    bool finished();
+
+    // 下一个等待时延的传输就绪的时刻，没有时返回FLOAT_MAX
+    float nextReadyTime();
+
+    std::vector<std::string> stageNames();
+
+    // 作业channelJob里src gpu到dst gpu的linkClass类型的channel，不存在时创建
+    int channel(int src, int dst, int linkClass);
+
+    // 增加一个src发给dst的传输，deps里的传输完成之后开始，返回传输的编号
+    int addTransfer(int src, int dst, float size, int stage, const std::vector<int>& deps);
+
+    // 增加一个没有数据的延时传输，deps里的传输完成并经过delay之后完成
+    int addDelay(const std::vector<int>& deps, float delay);
+
+    // 传输的所有part加入各自channel的队列，没有part时在time完成
+    void enqueue(int op, float time);
+
+    // 传输完成，依赖它的传输没有其他依赖时，在它的时延之后加入队列
+    void complete(int op, float time);
+
+    // 传输在time就绪：没有时延时直接加入队列，否则放入pending
+    void ready(int op, float time);
+
+    /*
+    在servers上展开一次collective，数据量与SimConfig::gpuDataSize为shard时相同，阶段从stage开始编号（见collectiveStages）
+    ready的下标为gpu编号，作业里每个gpu开始时等待ready里的传输，展开之后为这个gpu完成时需要等待的传输
+    */
+    void addCollective(Collective collective, const std::vector<int>& servers, float shard, int stage,
+                       std::vector<std::vector<int>>& ready);
+
+    /*
+    members按ring的顺序排列，每个step里第i个成员把size的数据发给第i + 1个，step k属于阶段stepStage[k]
+    第i个成员的第一个step在entry[i]里的传输都完成之后开始，返回每个成员完成时需要等待的传输
+    */
+    std::vector<std::vector<int>> addRing(const std::vector<int>& members, float size, const std::vector<int>& stepStage,
+                                          const std::vector<std::vector<int>>& entry);
+
+    /*
+    在一棵树上做流水线的reduce和broadcast：数据分成chunkNum个chunk，每个chunk先从叶子reduce到root，再从root broadcast到叶子
+    parent[i]为members[i]的父节点在members里的下标，root为-1；返回每个成员收到全部结果时需要等待的传输
+    */
+    std::vector<std::vector<int>> addTree(const std::vector<int>& members, const std::vector<int>& parent, float size,
+                                          int chunkNum, int reduceStage, int broadcastStage,
+                                          const std::vector<std::vector<int>>& entry);
+
+    // members上的double binary tree AllReduce：数据分成两半，分别在两棵互补的二叉树上流水线地reduce和broadcast
+    std::vector<std::vector<int>> addDoubleTree(const std::vector<int>& members, float size, int reduceStage,
+                                                int broadcastStage, const std::vector<std::vector<int>>& entry);
+
+    /*
+    members之间的all-to-all：每个成员给其他每个成员发送size的数据，分成若干个阶段，每个阶段每个成员发给peers个成员，
+    peers >= members.size() - 1时所有传输同时开始；返回每个成员收到所有数据时需要等待的传输
+    */
+    std::vector<std::vector<int>> addAllToAll(const std::vector<int>& members, float size, int peers, int stage,
+                                              const std::vector<std::vector<int>>& entry);
+};
+
+// collective的阶段名字
+std::vector<std::string> collectiveStages(Collective collective);
+
+// n个节点的二叉树（与NCCL相同的构造），second为true时得到与之互补的第二棵树，返回每个节点的父节点，root为-1
+std::vector<int> binaryTree(int n, bool second);
+
+#endif // SCHEDULE_H
\ No newline at end of file
@@ -22,50 +22,67 @@ void Server::init(int id, int gpuNum, float gpuDataSize, std::vector<std::vector
 
 // 对滑动窗口的初始化
 // 考虑对该server下的所有GPU都进行一样的操作
-void Server::initWindow(float len, float Cnvl, float Cnet, float Wnvl, float Wnet, float alpha, float delta) {
+void Server::initWindow(float len, float Cleft, float Cright, float Wleft, float Wright, float alpha, float delta) {
     this->len = len;
-    this->Cnvl = Cnvl;
-    this->Cnet = Cnet;
+    chunk[leftClass] = Cleft;
+    chunk[rightClass] = Cright;
     this->alpha = alpha;
     this->delta = delta;
+    // gpu.sendChunk按gpu自己的chunk大小发送，需要与server保持一致
+    for (auto& gpu: gpus) {
+        gpu.leftClass = leftClass;
+        gpu.rightClass = rightClass;
+        gpu.chunk[leftClass] = Cleft;
+        gpu.chunk[rightClass] = Cright;
+    }
     // 开始判断
     
-    // 在这两种情况下，分配给NVLink和Net的数据都固定好了，窗口不需要滑动了
-    if (this->len <= std::min(Wnvl, Wnet)) { // len < Wnvl && len < Wnet
-        this->Wnvl = this->len;
-        this->Wnet = 0;
+    // 在这两种情况下，分配给leftClass和rightClass的数据都固定好了，窗口不需要滑动了
+    if (this->len <= std::min(Wleft, Wright)) { // len < Wleft && len < Wright
+        window[leftClass] = this->len;
+        window[rightClass] = 0;
         for (auto& gpu: gpus) {
-            gpu.flows[0].dataSize = this->Wnvl;
+            gpu.flowOf(leftClass).dataSize() = window[leftClass];
             gpu.dataSize = 0;
         }
         return;
     }
-    else if (len <= Wnvl + Wnet) { // len < Wnet < Wnvl
-        this->Wnvl = Wnvl;
-        this->Wnet = len - Wnvl;
+    else if (len <= Wleft + Wright) { // len < Wright < Wleft
+        window[leftClass] = Wleft;
+        window[rightClass] = len - Wleft;
         for (auto& gpu: gpus) {
-            gpu.flows[0].dataSize = this->Wnvl;
-            gpu.flows[1].dataSize = this->Wnet;
+            gpu.flowOf(leftClass).dataSize() = window[leftClass];
+            gpu.flowOf(rightClass).dataSize() = window[rightClass];
             gpu.dataSize = 0;
         }
         return;
     }
-    this->Wnet = Wnet;
-    this->Wnvl = Wnvl;
-    left = this->Wnvl;
-    right = len - this->Wnet;
-    // 分配一个Cnvl和Cnet给flows[0]和flows[1]
+    window[rightClass] = Wright;
+    window[leftClass] = Wleft;
+    left = window[leftClass];
+    right = len - window[rightClass];
+    // 分配一个chunk给每个gpu的leftClass和rightClass的flow
     for (auto& gpu: gpus) {
-        gpu.sendChunk("NVLink");
-        gpu.sendChunk("Net");
+        gpu.sendChunk(leftClass);
+        gpu.sendChunk(rightClass);
     }
     return;
 }
 
-// 判断该server下的所有GPU是否都完成了
-bool Server::allRanksFinish(std::string protocol) {
+// 窗口状态保留到下一段数据，每个gpu的chunk统计清零
+void Server::nextWindow(float len) {
+    for (auto& gpu : gpus) {
+        for (auto& flow : gpu.flows) {
+            flow.chunkDataSize() = 0;
+        }
+    }
+    initWindow(len, chunk[leftClass], chunk[rightClass], window[leftClass], window[rightClass], alpha, delta);
+}
+
+// 判断该server下的所有GPU的该传输类型是否都完成了
+bool Server::allRanksFinish(int linkClass) {
     for (auto& gpu : gpus) {
-        if (!gpu.rankFinish(protocol)) {
+        if (!gpu.rankFinish(linkClass)) {
             return false;
         }
     }
@@ -77,13 +94,14 @@ void Server::computing(float unitTime) {
         return;
     }
     else if (0 < left && left < right) {
-        if (allRanksFinish("NVLink")) { //
-            left += Cnvl; // 考虑left与right临近时，可能有一定重叠，但是对仿真结果影响不大
+        if (allRanksFinish(leftClass)) { //
+            left += chunk[leftClass]; // 考虑left与right临近时，可能有一定重叠，但是对仿真结果影响不大
             for (auto& gpu : gpus) {
-                gpu.sendChunk("NVLink");
+                gpu.sendChunk(leftClass);
             }
         }
-        if (left < right && allRanksFinish("Net")) {
+        if (left < right && allRanksFinish(rightClass)) {
+            float Cright = chunk[rightClass];
             this->timeChunkNow = FLOAT_MAX;
             for (auto& gpu : gpus) {
                 if (gpu.timeChunkNow < this->timeChunkNow) {
@@ -91,18 +109,18 @@ void Server::computing(float unitTime) {
                 }
             }
             if (timeChunkNow - timeChunkLast < delta) { // 假设delta是你已经定义的变量
-                Wnet += alpha * Cnet; // 假设alpha是你已经定义的变量
-                right -= (alpha + 1) * Cnet;
+                window[rightClass] += alpha * Cright; // 假设alpha是你已经定义的变量
+                right -= (alpha + 1) * Cright;
                 for (auto& gpu : gpus) {
-                    gpu.sendChunk("Net");
+                    gpu.sendChunk(rightClass);
                 }
-            } else if (Wnet > Cnet) {
-                Wnet -= Cnet;
+            } else if (window[rightClass] > Cright) {
+                window[rightClass] -= Cright;
             }
             else {
-                right -= Cnet;
+                right -= Cright;
                 for (auto& gpu : gpus) {
-                    gpu.sendChunk("Net");
+                    gpu.sendChunk(rightClass);
                 }
             }
             this->timeChunkLast = this->timeChunkNow;
@@ -114,20 +132,22 @@ void Server::computing(float unitTime) {
     }
     else if(left >= right && right > 0){
         for (auto&gpu : gpus) {
-            gpu.flows[0].dataSize -= Cnvl; // 去掉left++时的sendChunk, left后退一格chunk
-            gpu.flows[0].chunkDataSize -= Cnvl;
+            Flow& leftFlow = gpu.flowOf(leftClass);
+            Flow& rightFlow = gpu.flowOf(rightClass);
+            leftFlow.dataSize() -= chunk[leftClass]; // 去掉left++时的sendChunk, left后退一格chunk
+            leftFlow.chunkDataSize() -= chunk[leftClass];
 
-            float nvlDataSize = right - gpu.flows[0].chunkDataSize;
-            float netDataSize = (len - right) - gpu.flows[1].chunkDataSize;
+            float leftDataSize = right - leftFlow.chunkDataSize();
+            float rightDataSize = (len - right) - rightFlow.chunkDataSize();
             // 考虑如果left和right如果重叠，那么right保持不变，left后退一点到right的值
         
-            gpu.dataSize -= nvlDataSize;
-            gpu.dataSize -= netDataSize;
+            gpu.dataSize -= leftDataSize;
+            gpu.dataSize -= rightDataSize;
 
-            gpu.flows[0].dataSize += nvlDataSize;
-            gpu.flows[1].dataSize += netDataSize;
-            gpu.flows[0].sentDataSize += nvlDataSize;
-            gpu.flows[1].sentDataSize += netDataSize;
+            leftFlow.dataSize() += leftDataSize;
+            rightFlow.dataSize() += rightDataSize;
+            leftFlow.sentDataSize() += leftDataSize;
+            rightFlow.sentDataSize() += rightDataSize;
         }
         left = -1;
         right = -1;
@@ -147,4 +167,19 @@ void Server::control(float unitTime) {
     for (auto& gpu : gpus) {
         gpu.control(unitTime);
     }
+}
+
+// 与GPU::windowPending相同，server级的滑动窗口在所有gpu的某个传输类型都发送完时需要在下一个unitTime决策
+bool Server::windowPending() {
+    if (!(left == -1 && right == -1)) {
+        if (left >= right || allRanksFinish(leftClass) || allRanksFinish(rightClass)) {
+            return true;
+        }
+    }
+    for (auto& gpu : gpus) {
+        if (gpu.windowPending()) {
+            return true;
+        }
+    }
+    return false;
 }
\ No newline at end of file
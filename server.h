@@ -13,11 +13,12 @@ public:
     std::vector<std::vector<float>> NVLink;
 
     // 有关滑动窗口的变量
+    // 窗口从左边分配数据给leftClass（默认NVLink），从右边分配数据给rightClass（默认Net）
+    int leftClass = LINK_NVLINK;
+    int rightClass = LINK_NET;
+    float chunk[LINK_CLASS_NUM] = {};  // 每种传输类型每次分配的chunk大小
+    float window[LINK_CLASS_NUM] = {}; // 每种传输类型的窗口大小
     float len; // len = dataSize;
-    float Cnvl;
-    float Cnet;
-    float Wnvl;
-    float Wnet;
     float left = -1;
     float right = -1;
     float timeChunkZero = FLOAT_MAX; // Time of the zero chunk
@@ -32,10 +33,13 @@ public:
     // Server的初始化函数，给Server的每个成员变量都赋值
     void init(int id, int gpuNum, float gpuDataSize, std::vector<std::vector<float>> NVLink);
 
-    //对滑动窗口的初始化
-    void initWindow(float len, float Cnvl, float Cnet, float Wnvl, float Wnet, float alpha, float delta);
+    //对滑动窗口的初始化，Cleft，Wleft是leftClass的chunk和窗口大小，Cright，Wright是rightClass的
+    void initWindow(float len, float Cleft, float Cright, float Wleft, float Wright, float alpha, float delta);
+
+    // 用当前的chunk和窗口大小（可能已经被alpha调整过）为新的一段数据重新开始滑动窗口
+    void nextWindow(float len);
     
-    bool allRanksFinish(std::string protocol);
+    bool allRanksFinish(int linkClass);
 
     void computing(float unitTime);
 
@@ -44,6 +48,9 @@ public:
 
     //
     void control(float unitTime);
+
+    // server或任意gpu的滑动窗口是否需要在下一个unitTime做决策
+    bool windowPending();
 };
 
 #endif // SERVER_H
\ No newline at end of file
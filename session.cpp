@@ -0,0 +1,287 @@
+#include "session.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+/*
+目标：
+    根据config创建一个独立的Network，得到time = 0的状态
+思路：
+    1. 创建，初始化网络，主种子为config.seed；congestionControl不为ideal时创建拥塞控制层
+    2. 给每个gpu创建NVLink和Net两个flow，数据由RingAllReduce在每个step开始时按mode分配
+       层次化和树形的AllReduce，all-to-all以及config.jobs里的作业由ScheduleCollective展开依赖图并创建自己的flow，
+       在路由之前创建，与gpu的flow一起路由
+    3. 按routing路由，按bgFlowModel生成背景流量，time = 0到达的trace记录在第一次分配rate之前加入
+    4. 开始第一个step，分配rate
+*/
+void SimSession::setup(const SimConfig& config) {
+    this->config = config;
+
+    // 1. 创建，初始化网络
+    std::vector<std::vector<float>> NVLink(config.gpuNum, std::vector<float>(config.gpuNum, config.NVLinkBandwidth));
+    network.seed(config.seed);
+    network.rateAllocator = config.rateAllocator;
+    network.topoType = config.topoType;
+    network.radix = config.radix;
+    network.oversubscription = config.oversubscription;
+    network.init(config.serverGroupNum, config.gpuNum, config.gpuDataSize, NVLink, config.topoBW);
+    network.setTickThreads(config.tickThreads);
+    if (config.congestionControl != CongestionModel::Ideal) {
+        network.congestion = std::make_unique<CongestionControl>();
+        CongestionControl& cc = *network.congestion;
+        cc.model = config.congestionControl;
+        cc.period = config.ccPeriod;
+        cc.baseRtt = config.ccBaseRtt;
+        cc.kmin = config.dcqcnKmin;
+        cc.kmax = config.dcqcnKmax;
+        cc.pmax = config.dcqcnPmax;
+        cc.rai = config.dcqcnRai;
+        cc.targetDelay = config.windowTargetDelay;
+        cc.windowAi = config.windowAi;
+        cc.init(network);
+    }
+
+    // 2. 给每个gpu创建NVLink和Net两个flow
+    for (auto& server : network.serverGroup) {
+        for (auto& gpu : server.gpus) {
+            std::pair<int, int> src = {server.id, gpu.rank};
+            std::pair<int, int> dst = {server.id, server.ring[src.second]};
+
+            Flow flowNVLink(&network.flowTable);
+            flowNVLink.init(src, dst, 0, LINK_NVLINK);
+            flowNVLink.setRate(server.NVLink[src.second][dst.second]);
+            gpu.addFlow(flowNVLink);
+
+            Flow flowNet(&network.flowTable);
+            flowNet.init(src, dst, 0, LINK_NET);
+            gpu.addFlow(flowNet);
+
+            network.gpuFlowManager.push_back(&gpu.flowOf(LINK_NET));
+        }
+    }
+    if (!config.jobs.empty() || (config.collective != Collective::Ring && config.collective != Collective::AllReduce)) {
+        schedule = std::make_unique<ScheduleCollective>();
+        schedule->init(&network, config);
+    }
+
+    // 3. 路由，生成背景流量
+    if (config.routing == RoutingMode::Fixed) {
+        network.Routing();
+    }
+    else {
+        network.ECMPRandom();
+    }
+    nextReroute = config.rerouteInterval;
+    if (config.bgFlowModel == BgFlowModel::Random) {
+        generateBgFlowRandom(bgFlows, network, config.bgFlowNum, config.bgFlowRoutingNum);
+    }
+    else if (config.bgFlowModel == BgFlowModel::Fixed) {
+        for (auto& path : config.bgFlowPaths) {
+            Flow flow(&network.flowTable, path.front(), path.back(), 0, LINK_NET);
+            flow.setPath(path);
+            bgFlows.push_back(flow);
+        }
+        for (auto& flow : bgFlows) {
+            network.bgFlowManager.push_back(&flow);
+        }
+    }
+    traffic.init(config, network, bgFlows);
+    if (!schedule) {
+        collective.init(&network, config, config.collective == Collective::AllReduce ? 2 * (config.gpuNum - 1) : 1);
+    }
+
+    std::vector<std::string> kindNames(linkClassName, linkClassName + LINK_CLASS_NUM);
+    kindNames.push_back("background");
+    std::vector<std::string> stageNames = schedule ? schedule->stageNames() : collective.stageNames();
+    stageNames.push_back("-");
+    bgStage = stageNames.size() - 1;
+    fctStats.init(kindNames, stageNames);
+    collective.fctStats = &fctStats;
+    if (schedule) {
+        schedule->fctStats = &fctStats;
+    }
+    bgFlowArrival.assign(bgFlows.size(), 0);
+
+    if (config.bgFlowModel == BgFlowModel::Trace) {
+        replay = std::make_unique<TraceReplay>();
+        if (replay->open(config.bgFlowTrace, &network)) {
+            replay->advance(0, &fctStats, bgKind, bgStage);
+        }
+        else {
+            std::cerr << "cannot open trace file: " << config.bgFlowTrace << std::endl;
+            replay.reset();
+        }
+    }
+
+    // 4. 开始第一个step，分配rate
+    if (schedule) {
+        schedule->start();
+    }
+    else {
+        collective.start();
+    }
+    network.allocateRate();
+}
+
+void SimSession::startTelemetry() {
+    if (config.telemetryFile.empty()) {
+        return;
+    }
+    telemetry = std::make_unique<LinkTelemetry>();
+    if (telemetry->open(config.telemetryFile, &network, config.telemetryStride, config.telemetryBuffer)) {
+        telemetry->sample(time);
+    }
+    else {
+        std::cerr << "cannot open telemetry file: " << config.telemetryFile << std::endl;
+        telemetry.reset();
+    }
+}
+
+/*
+目标：
+    事件驱动的模拟循环的一次迭代
+思路：
+    1. 不能跳过背景流量的到达事件，trace记录的到达时刻，自适应路由重新选择路径的时刻和schedule里传输的时延到期的时刻
+    2. step之后记录发送完的背景流量的FCT，处理到达事件和trace记录
+    3. control之后有新的step开始时，重新更新rate；到达rerouteInterval时重新选择路径，有flow换路径时再更新rate
+    4. 开启telemetry时，最后采样link的利用率
+*/
+bool SimSession::finished() {
+    return schedule ? schedule->finished() : collective.finished();
+}
+
+bool SimSession::tick() {
+    if (finished()) {
+        return false;
+    }
+
+    // 1. 下一个事件的时间
+    float dt = network.nextEventTime(config.unitTime);
+    // 背景流量的到达与下面的等待一样向上取整为unitTime的整数倍，每次决策至少间隔一个unitTime
+    if (traffic.nextEventTime() != FLOAT_MAX) {
+        float wait = std::ceil((traffic.nextEventTime() - time) / config.unitTime) * config.unitTime;
+        dt = std::min(dt, std::max(wait, config.unitTime));
+    }
+    // 不能跳过trace里下一条记录的到达时刻，向上取整为unitTime的整数倍
+    if (replay && replay->nextArrival() != (float)FLOAT_MAX) {
+        float wait = std::ceil((replay->nextArrival() - time) / config.unitTime) * config.unitTime;
+        dt = std::min(dt, std::max(wait, config.unitTime));
+    }
+    if (config.routing == RoutingMode::Adaptive) {
+        float wait = std::ceil((nextReroute - time) / config.unitTime) * config.unitTime;
+        dt = std::min(dt, std::max(wait, config.unitTime));
+    }
+    if (schedule && schedule->nextReadyTime() != (float)FLOAT_MAX) {
+        float wait = std::ceil((schedule->nextReadyTime() - time) / config.unitTime) * config.unitTime;
+        dt = std::min(dt, std::max(wait, config.unitTime));
+    }
+    time += dt;
+    steps++;
+
+    network.step(dt);
+
+    // 2. 背景流量在这次step里发送完（上一次updateRate时还在发送，现在dataSize为0），FCT为现在的时刻减去数据到达的时刻
+    for (size_t i = 0; i < bgFlows.size(); i++) {
+        if (bgFlows[i].active && bgFlows[i].dataSize() <= 0) {
+            fctStats.add(bgKind, bgStage, time - bgFlowArrival[i]);
+        }
+    }
+
+    // 背景流量的到达事件，记录到达空闲flow的时刻
+    traffic.advance(time, &bgFlowArrival);
+
+    // 加入到达的trace记录，回收发送完的flow
+    if (replay) {
+        replay->advance(time, &fctStats, bgKind, bgStage);
+    }
+
+    network.control(dt);
+
+    // 3. 输入已经就绪的gpu立即开始下一个step，新的数据需要计入link上的流数量
+    if (schedule ? schedule->progress(time) : collective.progress(time)) {
+        network.updateRate();
+    }
+    if (config.routing == RoutingMode::Adaptive && time >= nextReroute) {
+        int moved = network.RoutingAdaptive(config.migrationCost);
+        if (moved > 0) {
+            network.updateRate();
+        }
+        migrations += moved;
+        nextReroute = time + config.rerouteInterval;
+    }
+
+    // 4. 采样link的利用率
+    if (telemetry) {
+        telemetry->sample(time);
+    }
+    return true;
+}
+
+/*
+目标：
+    统计一次模拟的结果
+思路：
+    1. 统计gpu里flow和schedule的channel flow的最大completionTime，针对server里的gpu打印出flows里的completionTime和sentDataSize
+    2. 打印每个step的完成时间，自适应路由换路径的次数，每种flow在每个阶段的FCT分布
+*/
+SimResult SimSession::finish(std::ostream* log) {
+    if (telemetry) {
+        telemetry->close();
+    }
+
+    // 1. gpu里flow的最大completionTime
+    SimResult result;
+    result.time = time;
+    result.steps = steps;
+    result.migrations = migrations;
+    result.stepFinishTime = schedule ? schedule->stepFinishTime : collective.stepFinishTime;
+    if (schedule) {
+        result.jobs = schedule->jobResults();
+    }
+    result.fct = fctStats.summary();
+    for (auto& server : network.serverGroup) {
+        for (auto& gpu : server.gpus) {
+            if (log && config.printFlows) {
+                *log << "serverId: " << server.id << " gpuId: " << gpu.rank << std::endl;
+            }
+            for (auto& flow : gpu.flows) {
+                if (log && config.printFlows) {
+                    *log << linkClassName[flow.linkClass] << ": completionTime = " << flow.completionTime()
+                         << " sentdataSize = " << flow.sentDataSize() << std::endl;
+                }
+                result.maxTime = std::max(result.maxTime, flow.completionTime());
+            }
+        }
+    }
+    if (schedule) {
+        for (auto& flow : schedule->flows) {
+            result.maxTime = std::max(result.maxTime, flow.completionTime());
+        }
+    }
+
+    // 2. 每个step的完成时间和FCT分布
+    if (log && result.stepFinishTime.size() > 1) {
+        for (size_t step = 0; step < result.stepFinishTime.size(); step++) {
+            *log << "step " << step + 1 << " finish time: " << result.stepFinishTime[step] << std::endl;
+        }
+    }
+    if (log) {
+        for (auto& job : result.jobs) {
+            for (size_t k = 0; k < job.iterationTime.size(); k++) {
+                *log << "job " << job.name << " iteration " << k + 1 << " time: " << job.iterationTime[k]
+                     << " finish: " << job.finishTime[k] << std::endl;
+            }
+            *log << "job " << job.name << " mean iteration time: " << job.meanIterationTime << std::endl;
+        }
+    }
+    if (log && config.routing == RoutingMode::Adaptive) {
+        *log << "migrations: " << result.migrations << std::endl;
+    }
+    if (log) {
+        for (auto& item : result.fct) {
+            *log << "FCT " << item.kind << " " << item.stage << ": count = " << item.count << " p50 = " << item.p50
+                 << " p90 = " << item.p90 << " p99 = " << item.p99 << " max = " << item.max << std::endl;
+        }
+    }
+    return result;
+}
\ No newline at end of file
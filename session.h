@@ -0,0 +1,70 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "collective.h"
+#include "network.h"
+#include "schedule.h"
+#include "simulation.h"
+#include "stats.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "traffic.h"
+
+/*
+一次模拟运行的全部状态，runSimulation按 setup，startTelemetry，重复tick直到返回false，finish 的顺序使用
+1. setup根据config创建网络，路由，生成背景流量，开始第一个step并分配rate，得到time = 0的状态
+2. 每次tick推进到下一个事件，与原来runSimulation里的循环相同
+3. checkpoint.h保存和恢复这里的状态：恢复时先用相同的结构参数调用setup重建拓扑和flow，再覆盖动态的状态
+Network里的flow通过指针互相引用，SimSession不能复制或移动
+*/
+class SimSession {
+public:
+    SimConfig config;
+    Network network;
+    std::vector<Flow> bgFlows;
+    BgTraffic traffic;
+    RingAllReduce collective;
+    // 层次化和树形的AllReduce，all-to-all和作业由schedule运行，此时collective不使用
+    std::unique_ptr<ScheduleCollective> schedule;
+
+    // FCT统计：gpu里的flow按传输类型和集合通信的阶段，背景流量的kind为bgKind，阶段为bgStage（"-"）
+    FctStats fctStats;
+    int bgKind = LINK_CLASS_NUM;
+    int bgStage = 0;
+    // 背景流量当前这段发送开始时（数据到达空闲的flow）的时刻
+    std::vector<float> bgFlowArrival;
+
+    std::unique_ptr<TraceReplay> replay;
+    std::unique_ptr<LinkTelemetry> telemetry;
+
+    float time = 0;
+    long long steps = 0; // 模拟循环的次数
+
+    // 自适应路由下一次重新选择路径的时刻，换路径的次数
+    float nextReroute = 0;
+    long long migrations = 0;
+
+    SimSession() {}
+    SimSession(const SimSession&) = delete;
+    SimSession& operator=(const SimSession&) = delete;
+
+    // 根据config创建网络和所有flow，开始第一个step并分配rate
+    void setup(const SimConfig& config);
+
+    // 开启telemetry时从当前的time开始采样
+    void startTelemetry();
+
+    // 推进到下一个事件，集合通信已经完成时返回false
+    bool tick();
+
+    // 集合通信已经完成
+    bool finished();
+
+    // 关闭telemetry，统计结果；log不为空时打印每个step的完成时间和FCT，printFlows时还打印每个gpu的flow
+    SimResult finish(std::ostream* log);
+};
+
+#endif // SESSION_H
\ No newline at end of file
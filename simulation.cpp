@@ -0,0 +1,605 @@
+#include "simulation.h"
+#include "checkpoint.h"
+#include "session.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+// collective参数和作业里的集合通信的名字，顺序与Collective相同
+static const char* const collectiveName[] = {"ring", "allReduce", "hierarchicalRing", "hierarchicalTree", "doubleBinaryTree",
+                                             "allToAll", "allToAllPairwise", "allToAllHierarchical"};
+static const int collectiveNum = sizeof(collectiveName) / sizeof(collectiveName[0]);
+
+/*
+目标：
+    解析一个作业
+思路：
+    1. 第一项不含'='时为作业的名字，否则名字为 "job" + 作业的编号
+    2. 之后每项为 name=value：collective为集合通信的名字，servers为逗号分隔的server编号或者 a-b 的范围，
+       size，start，compute为非负的数值（size大于0），iterations为正整数；server重复或有多余字符时返回false
+*/
+static bool parseJob(const std::string& value, int index, JobSpec& job) {
+    std::istringstream in(value);
+    std::string item;
+    job.name = "job" + std::to_string(index);
+    bool first = true;
+    while (in >> item) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            if (!first) {
+                return false;
+            }
+            job.name = item;
+            first = false;
+            continue;
+        }
+        first = false;
+        std::string key = item.substr(0, eq);
+        std::string text = item.substr(eq + 1);
+        if (key == "collective") {
+            int k = std::find(collectiveName, collectiveName + collectiveNum, text) - collectiveName;
+            if (k == collectiveNum) {
+                return false;
+            }
+            job.collective = (Collective)k;
+            continue;
+        }
+        if (key == "servers") {
+            std::istringstream list(text);
+            std::string range;
+            while (std::getline(list, range, ',')) {
+                int lower, upper;
+                char dash;
+                std::istringstream part(range);
+                if (!(part >> lower) || lower < 0) {
+                    return false;
+                }
+                upper = lower;
+                if (part >> dash && (dash != '-' || !(part >> upper) || upper < lower)) {
+                    return false;
+                }
+                if (!(part >> std::ws).eof()) {
+                    return false;
+                }
+                for (int server = lower; server <= upper; server++) {
+                    if (std::find(job.servers.begin(), job.servers.end(), server) != job.servers.end()) {
+                        return false;
+                    }
+                    job.servers.push_back(server);
+                }
+            }
+            if (job.servers.empty()) {
+                return false;
+            }
+            continue;
+        }
+        std::istringstream number(text);
+        double f;
+        if (!(number >> f) || !(number >> std::ws).eof() || f < 0) {
+            return false;
+        }
+        if (key == "size" && f > 0) job.gpuDataSize = f;
+        else if (key == "start") job.startTime = f;
+        else if (key == "iterations" && f >= 1 && f == (int)f) job.iterations = f;
+        else if (key == "compute") job.computeTime = f;
+        else return false;
+    }
+    return true;
+}
+
+/*
+目标：
+    按名字设置SimConfig里的一个参数
+思路：
+    1. 枚举类型的参数用名字表示：
+        topology：leafSpine/fatTree
+        mode：ratio/gpuWindow/serverWindow
+        rateAllocator：waterFilling/maxMin
+        congestionControl：ideal/dcqcn/window
+        routing：fixed/ecmp/adaptive
+        collective：ring/allReduce/hierarchicalRing/hierarchicalTree/doubleBinaryTree/allToAll/allToAllPairwise/allToAllHierarchical
+        bgFlowModel：none/random/fixed/trace
+        bgFlowArrival：periodic/poisson/onOff
+        bgFlowSizeDist：uniform/fixed/pareto/lognormal/webSearch/dataMining
+    2. bgFlow是一条以空格分隔的路径，每次增加一个背景流量；job每次增加一个作业，见parseJob
+    3. seed是64位整数
+    4. 其余参数先转换成数值，转换失败，有多余字符或者超出取值范围（例如gpuNum，gpuDataSize，unitTime，bgFlowPeriod，bgFlowSize必须大于0，
+       ratio在0到1之间，bgFlowNum不能为负）时返回false
+*/
+static bool assignParam(SimConfig& config, const std::string& name, const std::string& value) {
+    // 1. 枚举类型的参数
+    if (name == "name") {
+        config.name = value;
+        return true;
+    }
+    if (name == "bgFlowArrival") {
+        const char* arrivalName[] = {"periodic", "poisson", "onOff"};
+        for (int k = 0; k < 3; k++) {
+            if (value == arrivalName[k]) {
+                config.bgFlowArrival = (ArrivalProcess)k;
+                return true;
+            }
+        }
+        return false;
+    }
+    if (name == "bgFlowSizeDist") {
+        const char* distName[] = {"uniform", "fixed", "pareto", "lognormal", "webSearch", "dataMining"};
+        for (int k = 0; k < 6; k++) {
+            if (value == distName[k]) {
+                config.bgFlowSizeDist = (SizeDist)k;
+                return true;
+            }
+        }
+        return false;
+    }
+    if (name == "bgFlowTrace") {
+        config.bgFlowTrace = value;
+        return true;
+    }
+    if (name == "telemetryFile") {
+        config.telemetryFile = value;
+        return true;
+    }
+    if (name == "routing") {
+        const char* routingName[] = {"fixed", "ecmp", "adaptive"};
+        for (int k = 0; k < 3; k++) {
+            if (value == routingName[k]) {
+                config.routing = (RoutingMode)k;
+                return true;
+            }
+        }
+        return false;
+    }
+    if (name == "congestionControl") {
+        const char* modelName[] = {"ideal", "dcqcn", "window"};
+        for (int k = 0; k < 3; k++) {
+            if (value == modelName[k]) {
+                config.congestionControl = (CongestionModel)k;
+                return true;
+            }
+        }
+        return false;
+    }
+    if (name == "checkpointFile") {
+        config.checkpointFile = value;
+        return true;
+    }
+    if (name == "restoreFile") {
+        config.restoreFile = value;
+        return true;
+    }
+    if (name == "mode") {
+        if (value == "ratio") {
+            config.mode = SplitMode::Ratio;
+        }
+        else if (value == "gpuWindow") {
+            config.mode = SplitMode::GpuWindow;
+        }
+        else if (value == "serverWindow") {
+            config.mode = SplitMode::ServerWindow;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+    if (name == "rateAllocator") {
+        if (value == "waterFilling") {
+            config.rateAllocator = RateAllocator::WaterFilling;
+        }
+        else if (value == "maxMin") {
+            config.rateAllocator = RateAllocator::MaxMin;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+    if (name == "topology") {
+        if (value == "leafSpine") {
+            config.topoType = TopoType::LeafSpine;
+        }
+        else if (value == "fatTree") {
+            config.topoType = TopoType::FatTree;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+    if (name == "collective") {
+        for (int k = 0; k < collectiveNum; k++) {
+            if (value == collectiveName[k]) {
+                config.collective = (Collective)k;
+                return true;
+            }
+        }
+        return false;
+    }
+    if (name == "bgFlowModel") {
+        if (value == "none") {
+            config.bgFlowModel = BgFlowModel::None;
+        }
+        else if (value == "random") {
+            config.bgFlowModel = BgFlowModel::Random;
+        }
+        else if (value == "fixed") {
+            config.bgFlowModel = BgFlowModel::Fixed;
+        }
+        else if (value == "trace") {
+            config.bgFlowModel = BgFlowModel::Trace;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    // 2. 背景流量的路径
+    if (name == "bgFlow") {
+        std::vector<int> path;
+        std::istringstream in(value);
+        int node;
+        while (in >> node) {
+            path.push_back(node);
+        }
+        if (!in.eof() || path.size() < 2) {
+            return false;
+        }
+        config.bgFlowPaths.push_back(path);
+        return true;
+    }
+
+    // 作业
+    if (name == "job") {
+        JobSpec job;
+        if (!parseJob(value, config.jobs.size(), job)) {
+            return false;
+        }
+        config.jobs.push_back(job);
+        return true;
+    }
+
+    // 3. 种子是64位整数，不能经过double
+    if (name == "seed") {
+        std::istringstream in(value);
+        uint64_t seed;
+        if (value.empty() || value[0] == '-' || !(in >> seed) || !(in >> std::ws).eof()) {
+            return false;
+        }
+        config.seed = seed;
+        return true;
+    }
+
+    // 4. 数值参数
+    double number;
+    std::istringstream in(value);
+    if (!(in >> number) || !(in >> std::ws).eof()) {
+        return false;
+    }
+    float f = number;
+    int i = number;
+    if (name == "serverGroupNum" && i > 0) config.serverGroupNum = i;
+    else if (name == "gpuNum" && i > 0) config.gpuNum = i;
+    else if (name == "gpuDataSize" && f > 0) config.gpuDataSize = f;
+    else if (name == "NVLinkBandwidth" && f > 0) config.NVLinkBandwidth = f;
+    else if (name == "topoBW" && f > 0) config.topoBW = f;
+    else if (name == "radix" && i >= 2) config.radix = i;
+    else if (name == "oversubscription" && f > 0) config.oversubscription = f;
+    else if (name == "treeChunks" && i > 0) config.treeChunks = i;
+    else if (name == "transferLatency" && f >= 0) config.transferLatency = f;
+    else if (name == "allToAllPeers" && i > 0) config.allToAllPeers = i;
+    else if (name == "ratio" && f >= 0 && f <= 1) config.ratio = f;
+    else if (name == "len") config.len = f;
+    else if (name == "Cnvl") config.Cnvl = f;
+    else if (name == "Cnet") config.Cnet = f;
+    else if (name == "Wnvl") config.Wnvl = f;
+    else if (name == "Wnet") config.Wnet = f;
+    else if (name == "alpha") config.alpha = f;
+    else if (name == "delta") config.delta = f;
+    else if (name == "bgFlowNum" && i >= 0) config.bgFlowNum = i;
+    else if (name == "bgFlowRoutingNum" && i >= 0) config.bgFlowRoutingNum = i;
+    else if (name == "bgFlowPeriod" && f > 0) config.bgFlowPeriod = f;
+    else if (name == "bgFlowDataSizeRatio" && i > 0) config.bgFlowDataSizeRatio = i;
+    else if (name == "bgFlowSize" && f > 0) config.bgFlowSize = f;
+    else if (name == "bgFlowSizeShape" && f > 0) config.bgFlowSizeShape = f;
+    else if (name == "bgFlowLoad") config.bgFlowLoad = f;
+    else if (name == "bgFlowOnTime" && f > 0) config.bgFlowOnTime = f;
+    else if (name == "bgFlowOffTime" && f > 0) config.bgFlowOffTime = f;
+    else if (name == "unitTime" && f > 0) config.unitTime = f;
+    else if (name == "tickThreads" && i >= 0) config.tickThreads = i;
+    else if (name == "printFlows") config.printFlows = i != 0;
+    else if (name == "telemetryStride" && f > 0) config.telemetryStride = f;
+    else if (name == "telemetryBuffer" && i > 0) config.telemetryBuffer = i;
+    else if (name == "checkpointTime" && f >= 0) config.checkpointTime = f;
+    else if (name == "rerouteInterval" && f > 0) config.rerouteInterval = f;
+    else if (name == "migrationCost" && f >= 0) config.migrationCost = f;
+    else if (name == "ccPeriod" && f > 0) config.ccPeriod = f;
+    else if (name == "ccBaseRtt" && f > 0) config.ccBaseRtt = f;
+    else if (name == "dcqcnKmin" && f >= 0) config.dcqcnKmin = f;
+    else if (name == "dcqcnKmax" && f > 0) config.dcqcnKmax = f;
+    else if (name == "dcqcnPmax" && f > 0 && f <= 1) config.dcqcnPmax = f;
+    else if (name == "dcqcnRai" && f >= 0) config.dcqcnRai = f;
+    else if (name == "windowTargetDelay" && f >= 0) config.windowTargetDelay = f;
+    else if (name == "windowAi" && f >= 0) config.windowAi = f;
+    else return false;
+    return true;
+}
+
+/*
+目标：
+    按名字设置一个参数，设置之后的config不合法时不修改config并返回false
+思路：
+    1. 在config的副本上调用assignParam
+    2. 作业只按ratio分配server内的数据，滑动窗口对作业不起作用：有作业时mode必须为ratio，Cnvl，Cnet，Wnvl，Wnet，alpha，delta必须为默认值
+       检查的是设置之后的整个config，因此mode = ratio要在第一个job之前设置（默认的mode为serverWindow）；
+       不合法的组合（非ratio的mode或者窗口参数与job）无论先后顺序都会被拒绝，不会有被忽略的参数
+*/
+bool setParam(SimConfig& config, const std::string& name, const std::string& value) {
+    // 1. 在副本上设置
+    SimConfig next = config;
+    if (!assignParam(next, name, value)) {
+        return false;
+    }
+
+    // 2. 作业不使用滑动窗口
+    const SimConfig defaults;
+    if (!next.jobs.empty() && (next.mode != SplitMode::Ratio || next.Cnvl != defaults.Cnvl || next.Cnet != defaults.Cnet ||
+                               next.Wnvl != defaults.Wnvl || next.Wnet != defaults.Wnet || next.alpha != defaults.alpha ||
+                               next.delta != defaults.delta)) {
+        return false;
+    }
+    config = next;
+    return true;
+}
+
+std::string getParam(const SimConfig& config, const std::string& name) {
+    std::ostringstream out;
+    if (name == "name") out << config.name;
+    else if (name == "mode") {
+        const char* modeName[] = {"ratio", "gpuWindow", "serverWindow"};
+        out << modeName[(int)config.mode];
+    }
+    else if (name == "collective") {
+        out << collectiveName[(int)config.collective];
+    }
+    else if (name == "bgFlowModel") {
+        const char* modelName[] = {"none", "random", "fixed", "trace"};
+        out << modelName[(int)config.bgFlowModel];
+    }
+    else if (name == "bgFlow") {
+        for (size_t i = 0; i < config.bgFlowPaths.size(); i++) {
+            for (size_t j = 0; j < config.bgFlowPaths[i].size(); j++) {
+                out << (j == 0 ? (i == 0 ? "" : ",") : " ") << config.bgFlowPaths[i][j];
+            }
+        }
+    }
+    else if (name == "job") {
+        for (size_t i = 0; i < config.jobs.size(); i++) {
+            const JobSpec& job = config.jobs[i];
+            out << (i == 0 ? "" : ";") << job.name << " collective=" << collectiveName[(int)job.collective];
+            for (size_t j = 0; j < job.servers.size(); j++) {
+                out << (j == 0 ? " servers=" : ",") << job.servers[j];
+            }
+            if (job.gpuDataSize > 0) {
+                out << " size=" << job.gpuDataSize;
+            }
+            out << " start=" << job.startTime << " iterations=" << job.iterations << " compute=" << job.computeTime;
+        }
+    }
+    else if (name == "rateAllocator") out << (config.rateAllocator == RateAllocator::MaxMin ? "maxMin" : "waterFilling");
+    else if (name == "serverGroupNum") out << config.serverGroupNum;
+    else if (name == "gpuNum") out << config.gpuNum;
+    else if (name == "gpuDataSize") out << config.gpuDataSize;
+    else if (name == "NVLinkBandwidth") out << config.NVLinkBandwidth;
+    else if (name == "topoBW") out << config.topoBW;
+    else if (name == "topology") out << (config.topoType == TopoType::FatTree ? "fatTree" : "leafSpine");
+    else if (name == "radix") out << config.radix;
+    else if (name == "oversubscription") out << config.oversubscription;
+    else if (name == "treeChunks") out << config.treeChunks;
+    else if (name == "transferLatency") out << config.transferLatency;
+    else if (name == "allToAllPeers") out << config.allToAllPeers;
+    else if (name == "ratio") out << config.ratio;
+    else if (name == "len") out << config.len;
+    else if (name == "Cnvl") out << config.Cnvl;
+    else if (name == "Cnet") out << config.Cnet;
+    else if (name == "Wnvl") out << config.Wnvl;
+    else if (name == "Wnet") out << config.Wnet;
+    else if (name == "alpha") out << config.alpha;
+    else if (name == "delta") out << config.delta;
+    else if (name == "bgFlowNum") out << config.bgFlowNum;
+    else if (name == "bgFlowRoutingNum") out << config.bgFlowRoutingNum;
+    else if (name == "bgFlowPeriod") out << config.bgFlowPeriod;
+    else if (name == "bgFlowDataSizeRatio") out << config.bgFlowDataSizeRatio;
+    else if (name == "bgFlowTrace") out << config.bgFlowTrace;
+    else if (name == "bgFlowArrival") {
+        const char* arrivalName[] = {"periodic", "poisson", "onOff"};
+        out << arrivalName[(int)config.bgFlowArrival];
+    }
+    else if (name == "bgFlowSizeDist") {
+        const char* distName[] = {"uniform", "fixed", "pareto", "lognormal", "webSearch", "dataMining"};
+        out << distName[(int)config.bgFlowSizeDist];
+    }
+    else if (name == "bgFlowSize") out << config.bgFlowSize;
+    else if (name == "bgFlowSizeShape") out << config.bgFlowSizeShape;
+    else if (name == "bgFlowLoad") out << config.bgFlowLoad;
+    else if (name == "bgFlowOnTime") out << config.bgFlowOnTime;
+    else if (name == "bgFlowOffTime") out << config.bgFlowOffTime;
+    else if (name == "seed") out << config.seed;
+    else if (name == "unitTime") out << config.unitTime;
+    else if (name == "tickThreads") out << config.tickThreads;
+    else if (name == "printFlows") out << config.printFlows;
+    else if (name == "telemetryFile") out << config.telemetryFile;
+    else if (name == "telemetryStride") out << config.telemetryStride;
+    else if (name == "telemetryBuffer") out << config.telemetryBuffer;
+    else if (name == "checkpointFile") out << config.checkpointFile;
+    else if (name == "checkpointTime") out << config.checkpointTime;
+    else if (name == "restoreFile") out << config.restoreFile;
+    else if (name == "routing") {
+        const char* routingName[] = {"fixed", "ecmp", "adaptive"};
+        out << routingName[(int)config.routing];
+    }
+    else if (name == "rerouteInterval") out << config.rerouteInterval;
+    else if (name == "migrationCost") out << config.migrationCost;
+    else if (name == "congestionControl") {
+        const char* modelName[] = {"ideal", "dcqcn", "window"};
+        out << modelName[(int)config.congestionControl];
+    }
+    else if (name == "ccPeriod") out << config.ccPeriod;
+    else if (name == "ccBaseRtt") out << config.ccBaseRtt;
+    else if (name == "dcqcnKmin") out << config.dcqcnKmin;
+    else if (name == "dcqcnKmax") out << config.dcqcnKmax;
+    else if (name == "dcqcnPmax") out << config.dcqcnPmax;
+    else if (name == "dcqcnRai") out << config.dcqcnRai;
+    else if (name == "windowTargetDelay") out << config.windowTargetDelay;
+    else if (name == "windowAi") out << config.windowAi;
+    return out.str();
+}
+
+/*
+目标：
+    读取场景文件，设置config里的参数
+思路：
+    1. 去掉每行#后面的注释和首尾空白，跳过空行
+    2. 按第一个=分成name和value，调用setParam
+*/
+bool loadScenario(const std::string& path, SimConfig& config) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << path << ": cannot open" << std::endl;
+        return false;
+    }
+    auto trim = [](const std::string& str) {
+        size_t begin = str.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) {
+            return std::string();
+        }
+        size_t end = str.find_last_not_of(" \t\r");
+        return str.substr(begin, end - begin + 1);
+    };
+
+    std::string line;
+    int lineNum = 0;
+    while (std::getline(file, line)) {
+        lineNum++;
+        // 1. 去掉注释和首尾空白
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        // 2. name = value
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << path << ":" << lineNum << ": expected name = value" << std::endl;
+            return false;
+        }
+        std::string name = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        if (!setParam(config, name, value)) {
+            std::cerr << path << ":" << lineNum << ": invalid parameter " << name << " = " << value << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+目标：
+    在leaf之间随机生成bgFlowNum个背景流量，dataSize为0，由突发周期性地增加
+思路：
+    1. leaf的编号范围由network生成的拓扑给出
+    2. 随机选择src leaf和dst leaf，再随机选择一条等价最短路径，尽量让路径上link的流数量小于bgFlowRoutingNum，最多尝试10次
+       每个背景流量的随机数来自自己的stream
+*/
+void generateBgFlowRandom(std::vector<Flow>& bgFlows, Network& network, int bgFlowNum, int bgFlowRoutingNum) {
+    for (int i = 0; i < bgFlowNum; i++) {
+        // 1. 随机选择src leaf和dst leaf
+        RandomStream rng = network.stream(RNG_BG_FLOW_PLACE, i);
+        int srcLeafId = network.leafBase + rng.below(network.leafNum);
+        int dstLeafId = network.leafBase + rng.below(network.leafNum);
+        while (srcLeafId == dstLeafId) {
+            dstLeafId = network.leafBase + rng.below(network.leafNum);
+        }
+        Flow flow(&network.flowTable, srcLeafId, dstLeafId, 0, LINK_NET);
+
+        // 2. 随机选择路径
+        int pathNum = network.ecmpPathNum(srcLeafId, dstLeafId);
+        std::vector<int> path;
+        int count = 0;
+        bool full;
+        do {
+            if (count > 10) {
+                break;
+            }
+            path = network.ecmpPath(srcLeafId, dstLeafId, rng.below(pathNum));
+            count++;
+            full = false;
+            for (size_t j = 0; j + 1 < path.size(); j++) {
+                if (network.linkFlowNum[network.linkId(path[j], path[j + 1])] >= bgFlowRoutingNum) {
+                    full = true;
+                    break;
+                }
+            }
+        } while (full);
+
+        flow.setPath(path);
+        bgFlows.push_back(flow);
+    }
+
+    for (auto& flow : bgFlows) {
+        network.bgFlowManager.push_back(&flow);
+    }
+}
+
+/*
+目标：
+    根据config创建一个独立的Network并运行集合通信
+思路：
+    1. SimSession::setup创建网络，所有flow，开始第一个step；restoreFile不为空时再用checkpoint覆盖动态的状态
+    2. 重复tick直到集合通信完成；checkpointFile不为空时，在第一个time >= checkpointTime的时刻保存checkpoint，之后继续模拟
+    3. 统计结果
+*/
+SimResult runSimulation(const SimConfig& config, std::ostream* log) {
+    auto start = std::chrono::steady_clock::now();
+
+    // 1. 创建网络，从checkpoint恢复
+    SimSession session;
+    session.setup(config);
+    if (!config.restoreFile.empty()) {
+        std::string error;
+        if (!loadCheckpoint(config.restoreFile, session, error)) {
+            std::cerr << "cannot restore checkpoint " << config.restoreFile << ": " << error << std::endl;
+            SimResult result;
+            result.error = "cannot restore checkpoint " + config.restoreFile + ": " + error;
+            return result;
+        }
+    }
+    session.startTelemetry();
+
+    // 2. 模拟循环
+    bool saved = config.checkpointFile.empty();
+    while (true) {
+        if (!saved && session.time >= config.checkpointTime) {
+            if (!saveCheckpoint(config.checkpointFile, session)) {
+                std::cerr << "cannot write checkpoint file: " << config.checkpointFile << std::endl;
+            }
+            saved = true;
+        }
+        if (!session.tick()) {
+            break;
+        }
+    }
+    if (!saved) {
+        std::cerr << "simulation finished at " << session.time << " before checkpointTime, no checkpoint written" << std::endl;
+    }
+
+    // 3. 统计结果
+    SimResult result = session.finish(log);
+    auto end = std::chrono::steady_clock::now();
+    result.wallTime = std::chrono::duration<double, std::milli>(end - start).count();
+    return result;
+}
\ No newline at end of file
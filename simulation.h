@@ -0,0 +1,207 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "flow.h"
+#include "network.h"
+#include "stats.h"
+#include "traffic.h"
+
+// gpu的数据在NVLink和Net之间的分配方式
+enum class SplitMode {
+    Ratio,        // 按ratio固定分配，ratio = NVLink / (NVLink + Net)
+    GpuWindow,    // 每个gpu自己的滑动窗口
+    ServerWindow  // 每个server的滑动窗口
+};
+
+// 集合通信的类型
+enum class Collective {
+    Ring,      // 只模拟一个ring step
+    AllReduce, // ring AllReduce，reduce-scatter和all-gather共 2 * (gpuNum - 1) 个step，由RingAllReduce在同一个Network里连续运行
+    // 以下由ScheduleCollective展开成传输的依赖图运行（见schedule.h），AllReduce的数据量为 gpuDataSize * gpuNum，在所有server之间规约
+    HierarchicalRing, // server内ring reduce-scatter，每个rail（相同rank的gpu）在server之间做ring AllReduce，server内ring all-gather
+    HierarchicalTree, // 与HierarchicalRing相同，rail上改为double binary tree
+    DoubleBinaryTree, // 与NCCL的tree相同：每个channel在server之间有两棵互补的二叉树，server内为一条链，数据分成两半流水线地reduce和broadcast
+    // all-to-all：每个gpu把 gpuDataSize * gpuNum 的数据平均分给所有gpu（MoE的token分发）
+    AllToAll,            // 所有gpu同时发给其他所有gpu，N x N的flow同时发送
+    AllToAllPairwise,    // 分阶段：每个阶段每个gpu只发给allToAllPeers个gpu，收发都完成之后进入下一个阶段
+    AllToAllHierarchical // 先在server内把发给每个rank的数据汇总到这个rank的gpu，再在每个rail上做server之间的all-to-all
+};
+
+// gpu flow的路由
+enum class RoutingMode {
+    Fixed,   // server i的flow经过第i条等价路径（Network::Routing）
+    Ecmp,    // 随机选择一条等价路径（Network::ECMPRandom），静态的ECMP
+    Adaptive // 从ECMP开始，每隔rerouteInterval按link上的流数量重新选择正在发送的flow的路径（Network::RoutingAdaptive）
+};
+
+// 背景流量的模型
+enum class BgFlowModel {
+    None,   // 没有背景流量
+    Random, // 在leaf之间随机生成bgFlowNum个背景流量
+    Fixed,  // 使用bgFlowPaths里给出的路径
+    Trace   // 回放bgFlowTrace文件里的记录，见trace.h
+};
+
+/*
+共享网络的一个作业：在servers上运行自己的集合通信，从startTime开始迭代iterations次，
+每次迭代完成之后经过computeTime的计算再开始下一次迭代；所有作业使用同一个Network的link和rateAllocator
+*/
+struct JobSpec {
+    std::string name;
+    Collective collective = Collective::AllReduce;
+    std::vector<int> servers; // 作业使用的server，按rank的顺序排列，为空时使用所有server
+    float gpuDataSize = -1;   // 小于0时取SimConfig::gpuDataSize
+    float startTime = 0;
+    int iterations = 1;
+    float computeTime = 0;
+};
+
+/*
+一次模拟的全部参数，与原来各个main()里的参数设置相同
+Cnvl，Cnet，Wnvl，Wnet，len小于0时取默认值：
+    Cnvl = NVLinkBandwidth，Cnet = topoBW，Wnvl = Cnvl，Wnet = Cnet，len = gpuDataSize
+*/
+struct SimConfig {
+    std::string name;
+
+    int serverGroupNum = 8;
+    int gpuNum = 8;
+    float gpuDataSize = 1024;
+    float NVLinkBandwidth = 1.6384;
+    float topoBW = 0.4096;
+
+    // 网络拓扑，默认的leafSpine，radix = 16，oversubscription = 1在8server 8gpu时为8个leaf，8个spine
+    TopoType topoType = TopoType::LeafSpine;
+    int radix = 16;
+    float oversubscription = 1;
+
+    Collective collective = Collective::Ring;
+    // 树形算法里每一半数据流水线的chunk数量
+    int treeChunks = 8;
+    // schedule的算法里每个传输在依赖完成之后再等待的固定时延（α-β模型里的α），用于比较不同数据量下的算法
+    float transferLatency = 0;
+    // allToAllPairwise每个阶段每个gpu发送的gpu数量，N个gpu时共 ceil((N - 1) / allToAllPeers) 个阶段
+    int allToAllPeers = 1;
+    // 不为空时按作业运行，不再使用collective，所有作业都完成时模拟结束，见JobSpec
+    std::vector<JobSpec> jobs;
+
+    // gpu flow的路由，adaptive时换路径的代价为migrationCost时间
+    RoutingMode routing = RoutingMode::Fixed;
+    float rerouteInterval = 100;
+    float migrationCost = 0;
+
+    SplitMode mode = SplitMode::ServerWindow;
+    float ratio = 0.8;
+
+    // 滑动窗口的参数
+    float len = -1;
+    float Cnvl = -1;
+    float Cnet = -1;
+    float Wnvl = -1;
+    float Wnet = -1;
+    float alpha = 0;
+    float delta = 1;
+
+    // 背景流量的参数，默认每隔bgFlowPeriod，每个背景流量增加 gpuDataSize * (0 ~ 9) / bgFlowDataSizeRatio 的数据
+    BgFlowModel bgFlowModel = BgFlowModel::Random;
+    std::vector<std::vector<int>> bgFlowPaths;
+    int bgFlowNum = 10;
+    int bgFlowRoutingNum = 2;
+    float bgFlowPeriod = 300;
+    int bgFlowDataSizeRatio = 600;
+    std::string bgFlowTrace; // bgFlowModel为trace时的trace文件
+
+    // random/fixed背景流量的到达过程和数据大小的分布，见traffic.h
+    // 没有设置bgFlowSize（默认的-1）时取原来突发的平均大小，设置时必须大于0，bgFlowLoad小于0时平均到达间隔为bgFlowPeriod
+    // bgFlowLoad为背景流量占link容量的比例：经过同一条link的背景流量平分这条link容量的bgFlowLoad，
+    // 每个flow的到达率按它路径上最紧的link决定，所以任何link上背景流量的总负载都不超过 bgFlowLoad * linkBW，
+    // 是这条link上所有背景流量的瓶颈时恰好等于它
+    ArrivalProcess bgFlowArrival = ArrivalProcess::Periodic;
+    SizeDist bgFlowSizeDist = SizeDist::Uniform;
+    float bgFlowSize = -1;
+    float bgFlowSizeShape = 1.2;
+    float bgFlowLoad = -1;
+    float bgFlowOnTime = 1000;
+    float bgFlowOffTime = 1000;
+
+    // 随机数的主种子，路由，每个背景流量的位置和突发都使用由它派生的独立stream
+    uint64_t seed = 1;
+    RateAllocator rateAllocator = RateAllocator::WaterFilling;
+    float unitTime = 1;
+
+    // 拥塞控制，见congestion.h；ideal时rate直接等于rateAllocator的结果，作为理想的对照
+    CongestionModel congestionControl = CongestionModel::Ideal;
+    float ccPeriod = 10;
+    float ccBaseRtt = 10;
+    float dcqcnKmin = 0.04;
+    float dcqcnKmax = 1.6;
+    float dcqcnPmax = 0.01;
+    float dcqcnRai = 0.005;
+    float windowTargetDelay = 20;
+    float windowAi = 0.05;
+
+    // 每个tick里step和control使用的线程数量，1为串行，0为硬件线程数；大规模拓扑的单个模拟使用
+    int tickThreads = 1;
+
+    // 是否打印每个gpu里flow的completionTime和sentDataSize
+    bool printFlows = false;
+
+    // link的利用率时间序列，telemetryFile为空时不开启，每隔telemetryStride采样一次，缓冲telemetryBuffer个sample
+    std::string telemetryFile;
+    float telemetryStride = 100;
+    int telemetryBuffer = 64;
+
+    // checkpointFile不为空时，在第一个 time >= checkpointTime 的时刻保存全部的模拟状态，之后继续模拟，见checkpoint.h
+    // restoreFile不为空时从checkpoint继续模拟：结构参数必须与checkpoint相同，其他参数可以不同，用于从同一个状态分出多个what-if
+    std::string checkpointFile;
+    float checkpointTime = 0;
+    std::string restoreFile;
+};
+
+// 一个作业每次迭代的完成时间和持续时间（从迭代的输入就绪到最后一个gpu完成，不含computeTime）
+struct JobResult {
+    std::string name;
+    std::vector<float> finishTime;
+    std::vector<float> iterationTime;
+    float meanIterationTime = 0;
+};
+
+// 一次模拟的结果
+struct SimResult {
+    float time = 0;      // 集合通信的完成时间，即所有gpu完成所有step的时间
+    float maxTime = 0;   // gpu里flow的最大completionTime
+    std::vector<float> stepFinishTime; // 每个step最后一个gpu完成的时间
+    std::vector<FctSummary> fct;       // 每种flow在每个阶段的FCT分布
+    std::vector<JobResult> jobs;       // 按作业运行时每个作业的迭代时间
+    long long steps = 0; // 模拟循环的次数
+    long long migrations = 0; // 自适应路由换路径的次数
+    double wallTime = 0; // 模拟耗时，单位ms
+    std::string error;   // 不为空时模拟没有运行，例如checkpoint不能恢复
+};
+
+// 按名字设置一个参数，名字与SimConfig的成员名相同；名字或值不合法时返回false
+// bgFlow的值为一条路径，例如 "64 73 66"，每次设置增加一个背景流量
+// job的值为 "名字 collective=allToAll servers=0-3,6 size=2048 start=0 iterations=4 compute=500"，名字之后的项都可以省略，每次设置增加一个作业
+// 作业只使用ratio：有作业时mode必须为ratio（在第一个job之前设置），滑动窗口的参数（Cnvl，Cnet，Wnvl，Wnet，alpha，delta）不能设置
+bool setParam(SimConfig& config, const std::string& name, const std::string& value);
+
+// 参数的值转换成字符串，用于输出结果
+std::string getParam(const SimConfig& config, const std::string& name);
+
+// 在leaf之间随机生成bgFlowNum个背景流量，第i个背景流量的随机数来自network.stream(RNG_BG_FLOW_PLACE, i)
+void generateBgFlowRandom(std::vector<Flow>& bgFlows, Network& network, int bgFlowNum, int bgFlowRoutingNum);
+
+/*
+读取场景文件，每行一个 name = value，#后面是注释，name与setParam相同
+文件不存在或有不合法的行时在std::cerr里给出行号并返回false
+*/
+bool loadScenario(const std::string& path, SimConfig& config);
+
+// 根据config创建一个独立的Network并运行集合通信，不使用任何全局状态，可以在多个线程里同时调用
+// log不为空时打印每个step的完成时间，printFlows时还打印每个gpu的flow
+SimResult runSimulation(const SimConfig& config, std::ostream* log = nullptr);
+
+#endif // SIMULATION_H
\ No newline at end of file
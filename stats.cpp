@@ -0,0 +1,79 @@
+#include "stats.h"
+#include <algorithm>
+#include <cmath>
+
+/*
+目标：
+    把一个数值加到对应的对数桶里
+思路：
+    桶的编号为 floor(log(value / minValue) / log(gamma))，截断到 [0, bucketNum - 1]
+*/
+void QuantileSketch::add(double value) {
+    if (buckets.empty()) {
+        buckets.assign(bucketNum, 0);
+    }
+    int bucket = 0;
+    if (value > minValue) {
+        bucket = std::min(bucketNum - 1, (int)(std::log(value / minValue) / std::log(gamma)));
+    }
+    buckets[bucket]++;
+    min = count == 0 ? value : std::min(min, value);
+    max = count == 0 ? value : std::max(max, value);
+    sum += value;
+    count++;
+}
+
+/*
+目标：
+    求第q分位数
+思路：
+    1. 从小到大累加桶的数量，找到第 q * (count - 1) 个数值所在的桶
+    2. 返回桶的几何中点，再截断到 [min, max]，q = 0和q = 1时就是精确的min和max
+*/
+double QuantileSketch::quantile(double q) {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(q * (count - 1));
+    uint64_t seen = 0;
+    for (int i = 0; i < bucketNum; i++) {
+        seen += buckets[i];
+        if (seen > rank) {
+            double value = minValue * std::pow(gamma, i + 0.5);
+            return std::max(min, std::min(max, value));
+        }
+    }
+    return max;
+}
+
+void FctStats::init(const std::vector<std::string>& kindNames, const std::vector<std::string>& stageNames) {
+    this->kindNames = kindNames;
+    this->stageNames = stageNames;
+    sketches.assign(kindNames.size() * stageNames.size(), QuantileSketch());
+}
+
+void FctStats::add(int kind, int stage, double fct) {
+    sketches[kind * stageNames.size() + stage].add(fct);
+}
+
+std::vector<FctSummary> FctStats::summary() {
+    std::vector<FctSummary> result;
+    for (size_t kind = 0; kind < kindNames.size(); kind++) {
+        for (size_t stage = 0; stage < stageNames.size(); stage++) {
+            QuantileSketch& sketch = sketches[kind * stageNames.size() + stage];
+            if (sketch.count == 0) {
+                continue;
+            }
+            FctSummary item;
+            item.kind = kindNames[kind];
+            item.stage = stageNames[stage];
+            item.count = sketch.count;
+            item.p50 = sketch.quantile(0.5);
+            item.p90 = sketch.quantile(0.9);
+            item.p99 = sketch.quantile(0.99);
+            item.max = sketch.max;
+            result.push_back(item);
+        }
+    }
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+流式分位数sketch，大小固定，与加入的数值个数无关
+1. 数值按对数分桶：桶i覆盖 [minValue * gamma^i, minValue * gamma^(i+1))，gamma = 1.02，分位数的相对误差不超过1%
+2. bucketNum个桶覆盖 minValue ~ minValue * gamma^bucketNum（约1e-3 ~ 4e14），超出范围的数值放在两端的桶里
+3. 另外精确记录count，min，max，sum；桶在第一次add时才分配
+*/
+class QuantileSketch {
+public:
+    static constexpr int bucketNum = 2048;
+    static constexpr double gamma = 1.02;
+    static constexpr double minValue = 1e-3;
+
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    double min = 0;
+    double max = 0;
+    double sum = 0;
+
+    void add(double value);
+
+    // 第q分位数（0 <= q <= 1），没有数值时返回0
+    double quantile(double q);
+};
+
+// 一种flow在一个阶段里的完成时间分布
+struct FctSummary {
+    std::string kind;
+    std::string stage;
+    uint64_t count = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+/*
+flow完成时间（FCT）的统计，按(kind, stage)分别保存一个QuantileSketch
+kind：gpu里flow的传输类型（linkClassName）和背景流量
+stage：集合通信的阶段，例如reduceScatter，allGather，背景流量不属于任何阶段，使用"-"
+*/
+class FctStats {
+public:
+    std::vector<std::string> kindNames;
+    std::vector<std::string> stageNames;
+    std::vector<QuantileSketch> sketches; // sketches[kind * stageNames.size() + stage]
+
+    void init(const std::vector<std::string>& kindNames, const std::vector<std::string>& stageNames);
+
+    void add(int kind, int stage, double fct);
+
+    // 所有有数值的(kind, stage)的p50，p90，p99，max
+    std::vector<FctSummary> summary();
+};
+
+#endif // STATS_H
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "telemetry.h"
+#include <cmath>
+#include <cstdint>
+
+LinkTelemetry::~LinkTelemetry() {
+    close();
+}
+
+/*
+目标：
+    打开文件，写入文件头和link表，分配环形缓冲，启动后台线程
+思路：
+    1. link的src由CSR的linkOffset得到：linkOffset[u] ~ linkOffset[u + 1] - 1 是从u出发的link
+    2. 缓冲在这里一次分配好，采样时不再分配内存
+*/
+bool LinkTelemetry::open(const std::string& path, Network* network, float stride, int slotNum) {
+    out.open(path, std::ios::binary);
+    if (!out) {
+        return false;
+    }
+    this->network = network;
+    this->stride = stride;
+    this->slotNum = std::max(slotNum, 1);
+    linkNum = network->linkOffset.back(); // linkDst最后是noLink的哨兵，不属于任何节点
+    nextSample = 0;
+    head = 0;
+    tail = 0;
+    closing = false;
+
+    // 1. 文件头和link表
+    uint32_t version = 1;
+    uint32_t count = linkNum;
+    out.write("LTEL", 4);
+    out.write((const char*)&version, sizeof(version));
+    out.write((const char*)&count, sizeof(count));
+    out.write((const char*)&stride, sizeof(stride));
+    for (int u = 0; u + 1 < (int)network->linkOffset.size(); u++) {
+        for (int l = network->linkOffset[u]; l < network->linkOffset[u + 1]; l++) {
+            int32_t src = u;
+            int32_t dst = network->linkDst[l];
+            float bandwidth = network->linkBW[l];
+            out.write((const char*)&src, sizeof(src));
+            out.write((const char*)&dst, sizeof(dst));
+            out.write((const char*)&bandwidth, sizeof(bandwidth));
+        }
+    }
+
+    // 2. 环形缓冲和后台线程
+    times.assign(this->slotNum, 0);
+    flowNum.assign((size_t)this->slotNum * linkNum, 0);
+    rateSum.assign((size_t)this->slotNum * linkNum, 0);
+    writer = std::thread(&LinkTelemetry::writeLoop, this);
+    return true;
+}
+
+/*
+目标：
+    time到达下一个采样时刻时，采样每条link的流数量和rate之和
+思路：
+    1. 事件驱动的循环会跳过一些时刻，在第一个不早于采样时刻的tick采样，记录实际的time
+    2. 缓冲满时等待后台线程写完最早的sample
+    3. 流数量直接取linkFlowNum（只统计活跃的flow），rate之和遍历活跃flow的links累加
+    4. 写好slot之后才增加head，后台线程不会读到写了一半的sample
+*/
+void LinkTelemetry::sample(float time) {
+    if (time < nextSample) {
+        return;
+    }
+    nextSample = (std::floor(time / stride) + 1) * stride;
+
+    // 2. 等待空的slot
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return head - tail < slotNum; });
+    }
+
+    // 3. 采样
+    int slot = head % slotNum;
+    times[slot] = time;
+    int* slotFlowNum = &flowNum[(size_t)slot * linkNum];
+    float* slotRateSum = &rateSum[(size_t)slot * linkNum];
+    for (int l = 0; l < linkNum; l++) {
+        slotFlowNum[l] = network->linkFlowNum[l];
+        slotRateSum[l] = 0;
+    }
+    for (auto* manager : {&network->gpuFlowManager, &network->bgFlowManager}) {
+        for (Flow* flow : *manager) {
+            if (flow->active) {
+                for (int l : flow->links) {
+                    slotRateSum[l] += flow->rate();
+                }
+            }
+        }
+    }
+
+    // 4. 发布
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        head++;
+    }
+    notEmpty.notify_one();
+}
+
+/*
+目标：
+    后台线程把采样好的sample写到文件
+思路：
+    1. 等待有新的sample或者close
+    2. 一次取出[tail, head)里所有的sample，写文件时不持有锁，模拟线程可以继续采样到其他slot
+    3. 写完之后增加tail，唤醒可能在等待空slot的模拟线程
+*/
+void LinkTelemetry::writeLoop() {
+    while (true) {
+        long long begin, end;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this] { return head > tail || closing; });
+            if (head == tail && closing) {
+                return;
+            }
+            begin = tail;
+            end = head;
+        }
+        for (long long k = begin; k < end; k++) {
+            int slot = k % slotNum;
+            out.write((const char*)&times[slot], sizeof(float));
+            out.write((const char*)&flowNum[(size_t)slot * linkNum], sizeof(int) * linkNum);
+            out.write((const char*)&rateSum[(size_t)slot * linkNum], sizeof(float) * linkNum);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tail = end;
+        }
+        notFull.notify_one();
+    }
+}
+
+void LinkTelemetry::close() {
+    if (!writer.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    notEmpty.notify_one();
+    writer.join();
+    out.close();
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "network.h"
+
+/*
+每条link的利用率时间序列
+1. 每隔stride时间采样一次：每条link上的活跃流数量和分配到的rate之和
+2. 采样写到预先分配的环形缓冲里（slotNum个sample），后台线程把写好的sample批量写到二进制文件，模拟线程不做文件IO
+3. 缓冲满时模拟线程等待后台线程，不丢弃sample
+4. 没有开启时runSimulation里只有一次指针判断，不影响每个tick的耗时
+
+文件格式（小端）：
+    char magic[4] = "LTEL"，uint32 version = 1，uint32 linkNum，float stride
+    linkNum个 {int32 src, int32 dst, float bandwidth}，顺序与Network的link编号相同
+    之后每个sample一条记录直到文件结束：float time，int32 flowNum[linkNum]，float rateSum[linkNum]
+*/
+class LinkTelemetry {
+public:
+    Network* network = nullptr;
+    float stride = 100;
+    float nextSample = 0;
+    int linkNum = 0;
+    int slotNum = 64;
+
+    // 环形缓冲，第k个sample在slot k % slotNum里
+    std::vector<float> times;
+    std::vector<int> flowNum;     // flowNum[slot * linkNum + l]
+    std::vector<float> rateSum;   // rateSum[slot * linkNum + l]
+
+    // head：已经采样的数量，tail：已经写到文件的数量，head - tail <= slotNum
+    long long head = 0;
+    long long tail = 0;
+    bool closing = false;
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::thread writer;
+    std::ofstream out;
+
+    ~LinkTelemetry();
+
+    // 打开文件，写入文件头和link表，启动后台线程；文件无法打开时返回false
+    bool open(const std::string& path, Network* network, float stride, int slotNum);
+
+    // 在每个tick的control之后调用，time到达下一个采样时刻时采样一次
+    void sample(float time);
+
+    // 写完所有sample，结束后台线程，关闭文件
+    void close();
+
+    // 后台线程：把[tail, head)里的sample写到文件
+    void writeLoop();
+};
+
+#endif // TELEMETRY_H
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threadNum) {
+    if (threadNum <= 0) {
+        threadNum = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < threadNum; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < threadNum; i++) {
+        threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    taskReady.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = nextWorker;
+        nextWorker = (nextWorker + 1) % workers.size();
+        pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers[id]->mutex);
+        workers[id]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued++;
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return pending == 0; });
+}
+
+/*
+目标：
+    为线程id取一个任务
+思路：
+    1. 先从自己的队尾取，最近放入的任务数据还在cache里
+    2. 自己的队列为空时，依次从其他线程的队首偷任务
+*/
+bool ThreadPool::popTask(int id, std::function<void()>& task) {
+    int workerNum = workers.size();
+    for (int i = 0; i < workerNum; i++) {
+        Worker& worker = *workers[(id + i) % workerNum];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) {
+            continue;
+        }
+        // 1. 自己的队尾
+        if (i == 0) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        // 2. 其他线程的队首
+        else {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(int id) {
+    while (true) {
+        std::function<void()> task;
+        if (popTask(id, task)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queued--;
+            }
+            task();
+            std::lock_guard<std::mutex> lock(mutex);
+            pending--;
+            if (pending == 0) {
+                allDone.notify_all();
+            }
+            continue;
+        }
+        // 所有队列都为空，等待新的任务
+        std::unique_lock<std::mutex> lock(mutex);
+        taskReady.wait(lock, [this] { return stop || queued > 0; });
+        if (stop && queued == 0) {
+            return;
+        }
+    }
+}
+
+ShardPool::ShardPool(int shardNum) {
+    if (shardNum <= 0) {
+        shardNum = std::max(1u, std::thread::hardware_concurrency());
+    }
+    this->shardNum = shardNum;
+    for (int shard = 1; shard < shardNum; shard++) {
+        threads.emplace_back(&ShardPool::work, this, shard);
+    }
+}
+
+ShardPool::~ShardPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+int ShardPool::shardBegin(int n, int shard) {
+    return (long long)n * shard / shardNum;
+}
+
+/*
+目标：
+    所有分片并行运行task，全部完成后返回
+思路：
+    1. 在锁里增加generation并唤醒睡眠的线程，自旋的线程直接看到新的generation
+    2. 调用者运行分片0
+    3. 等待remaining变为0：先自旋，再在done上睡眠；最后一个完成的线程在锁里通知，不会丢失唤醒
+*/
+void ShardPool::run(const std::function<void(int)>& task) {
+    if (shardNum == 1) {
+        task(0);
+        return;
+    }
+    // 1. 开始
+    this->task = &task;
+    remaining.store(shardNum - 1);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+    }
+    wake.notify_all();
+
+    // 2. 分片0
+    task(0);
+
+    // 3. 等待其他分片
+    for (int i = 0; i < spinCount && remaining.load() > 0; i++) {
+        std::this_thread::yield();
+    }
+    if (remaining.load() > 0) {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return remaining.load() == 0; });
+    }
+}
+
+void ShardPool::work(int shard) {
+    long long seen = 0;
+    while (true) {
+        // 等待新的generation：先自旋，再睡眠
+        for (int i = 0; i < spinCount && generation.load() == seen; i++) {
+            std::this_thread::yield();
+        }
+        if (generation.load() == seen) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen] { return stop || generation.load() != seen; });
+            if (stop) {
+                return;
+            }
+        }
+        seen = generation.load();
+
+        (*task)(shard);
+
+        if (remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_one();
+        }
+    }
+}
\ No newline at end of file
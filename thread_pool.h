@@ -0,0 +1,88 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+work-stealing线程池
+每个线程有自己的任务队列，从队尾取自己的任务，自己的队列为空时从其他线程的队首偷任务
+任务运行时间差别很大（不同参数的模拟时间不同）时，空闲的线程会帮忙完成其他线程剩下的任务
+*/
+class ThreadPool {
+public:
+    struct Worker {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable allDone;
+    int queued = 0;     // 队列里还没有被取走的任务数量
+    int pending = 0;    // 还没有运行完的任务数量
+    int nextWorker = 0; // 下一个任务放入的队列，轮流放入
+    bool stop = false;
+
+    // threadNum为0时使用硬件线程数
+    ThreadPool(int threadNum = 0);
+    ~ThreadPool();
+
+    // 提交一个任务
+    void submit(std::function<void()> task);
+
+    // 等待所有已经提交的任务运行完
+    void wait();
+
+    // 从自己的队尾或者其他队列的队首取一个任务
+    bool popTask(int id, std::function<void()>& task);
+
+    // 每个线程的循环
+    void run(int id);
+};
+
+/*
+固定分片的并行区域，用于一个模拟内部每个tick的并行
+1. shardNum个分片，调用者自己运行分片0，shardNum - 1个常驻线程运行其他分片
+2. run(task)是一个并行区域：开始时唤醒所有线程（第一个barrier），所有分片完成后才返回（第二个barrier）
+3. 每个tick都会调用，等待时先短暂自旋再睡眠，减少唤醒的延迟
+*/
+class ShardPool {
+public:
+    int shardNum = 1;
+    std::vector<std::thread> threads;
+
+    const std::function<void(int)>* task = nullptr;
+    std::atomic<long long> generation{0}; // 每次run加1，线程看到新的generation时开始运行
+    std::atomic<int> remaining{0};        // 本次run还没有完成的线程数量
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool stop = false;
+
+    static constexpr int spinCount = 2000;
+
+    // shardNum为0时使用硬件线程数
+    ShardPool(int shardNum);
+    ~ShardPool();
+
+    // 所有分片并行运行task(shard)，全部完成后返回
+    void run(const std::function<void(int)>& task);
+
+    // 分片[begin, end)：n个元素里第shard个分片的起点
+    int shardBegin(int n, int shard);
+
+    // 常驻线程的循环
+    void work(int shard);
+};
+
+#endif // THREAD_POOL_H
\ No newline at end of file
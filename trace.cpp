@@ -0,0 +1,232 @@
+#include "trace.h"
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TraceFile::~TraceFile() {
+    close();
+}
+
+/*
+目标：
+    打开trace文件，检查文件头
+思路：
+    1. 文件头的recordNum必须与文件大小一致，避免读到写了一半的文件
+    2. 这里只读取文件头，记录在peek时按窗口映射
+*/
+bool TraceFile::open(const std::string& path, size_t windowSize) {
+    close();
+    this->windowSize = windowSize;
+    cursor = 0;
+    char header[headerSize];
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return false;
+    }
+    LARGE_INTEGER size;
+    DWORD readSize = 0;
+    if (!GetFileSizeEx(file, &size) || !ReadFile(file, header, headerSize, &readSize, nullptr) || readSize != headerSize) {
+        close();
+        return false;
+    }
+    fileSize = size.QuadPart;
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        close();
+        return false;
+    }
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || pread(fd, header, headerSize, 0) != (ssize_t)headerSize) {
+        close();
+        return false;
+    }
+    fileSize = st.st_size;
+#endif
+
+    // 1. 检查文件头
+    uint32_t version;
+    std::memcpy(&version, header + 4, sizeof(version));
+    std::memcpy(&recordNum, header + 8, sizeof(recordNum));
+    if (std::memcmp(header, "BGTR", 4) != 0 || version != 1 || headerSize + recordNum * sizeof(TraceRecord) != fileSize) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/*
+目标：
+    映射包含offset处一条记录的窗口
+思路：
+    窗口的起点按页（Windows为分配粒度）对齐，长度为windowSize再加上对齐多出来的部分，不超过文件末尾
+*/
+void TraceFile::map(uint64_t offset) {
+    unmap();
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    uint64_t granularity = info.dwAllocationGranularity;
+#else
+    uint64_t granularity = sysconf(_SC_PAGESIZE);
+#endif
+    windowBegin = offset / granularity * granularity;
+    windowEnd = std::min<uint64_t>(fileSize, std::max<uint64_t>(offset + sizeof(TraceRecord), offset + windowSize));
+#ifdef _WIN32
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)(windowBegin >> 32), (DWORD)windowBegin, windowEnd - windowBegin);
+    base = (const char*)view;
+#else
+    void* view = mmap(nullptr, windowEnd - windowBegin, PROT_READ, MAP_PRIVATE, fd, windowBegin);
+    if (view == MAP_FAILED) {
+        view = nullptr;
+    }
+    else {
+        madvise(view, windowEnd - windowBegin, MADV_SEQUENTIAL);
+    }
+    base = (const char*)view;
+#endif
+    if (base == nullptr) {
+        windowBegin = windowEnd = 0;
+    }
+}
+
+void TraceFile::unmap() {
+    if (base == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+#else
+    munmap((void*)base, windowEnd - windowBegin);
+#endif
+    base = nullptr;
+    windowBegin = windowEnd = 0;
+}
+
+bool TraceFile::peek(TraceRecord& record) {
+    if (cursor >= recordNum) {
+        return false;
+    }
+    uint64_t offset = headerSize + cursor * sizeof(TraceRecord);
+    if (base == nullptr || offset < windowBegin || offset + sizeof(TraceRecord) > windowEnd) {
+        map(offset);
+        if (base == nullptr) {
+            return false;
+        }
+    }
+    std::memcpy(&record, base + (offset - windowBegin), sizeof(TraceRecord));
+    return true;
+}
+
+void TraceFile::close() {
+    unmap();
+#ifdef _WIN32
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file != nullptr) {
+        CloseHandle(file);
+        file = nullptr;
+    }
+#else
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+bool TraceReplay::open(const std::string& path, Network* network, size_t windowSize) {
+    this->network = network;
+    return file.open(path, windowSize);
+}
+
+float TraceReplay::nextArrival() {
+    TraceRecord record;
+    if (!file.peek(record)) {
+        return FLOAT_MAX;
+    }
+    return record.time;
+}
+
+/*
+目标：
+    回收发送完的flow，加入time之前到达的记录
+思路：
+    1. 正在发送的flow已经计入link（active）并且dataSize为0时发送完，记录FCT，等待下一次updateRate把它从link上移除
+    2. 等待移除的flow不再active时回收；同一个tick里发送完的flow还在link上，不能马上复用
+    3. 每条记录的bytes换算成Mb（1MB = 8Mb），src或dst不是gpu/leaf，src = dst，或者bytes为0时跳过
+    4. 优先复用空闲的flow，没有时新建一个flow加入bgFlowManager；completionTime和sentDataSize清零
+*/
+void TraceReplay::advance(float time, FctStats* fctStats, int kind, int stage) {
+    // 1. 2. 发送完和可以回收的flow
+    size_t kept = 0;
+    for (int i : live) {
+        Flow& flow = flows[i];
+        if (state[i] == 1 && flow.active && flow.dataSize() <= 0) {
+            if (fctStats) {
+                fctStats->add(kind, stage, flow.completionTime());
+            }
+            state[i] = 2;
+        }
+        if (state[i] == 2 && !flow.active) {
+            state[i] = 0;
+            freeSlots.push_back(i);
+            continue;
+        }
+        live[kept++] = i;
+    }
+    live.resize(kept);
+
+    // 3. 到达的记录
+    int nodeEnd = network->leafBase + network->leafNum;
+    TraceRecord record;
+    while (file.peek(record) && record.time <= time) {
+        uint64_t index = file.cursor++;
+        bool gpuOrLeaf = (record.src >= 0 && record.src < network->gpuTotal) || (record.src >= network->leafBase && record.src < nodeEnd);
+        gpuOrLeaf = gpuOrLeaf && ((record.dst >= 0 && record.dst < network->gpuTotal) || (record.dst >= network->leafBase && record.dst < nodeEnd));
+        if (!gpuOrLeaf || record.src == record.dst || record.bytes == 0) {
+            skipped++;
+            continue;
+        }
+
+        // 4. 复用或者新建flow
+        int i;
+        if (!freeSlots.empty()) {
+            i = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            i = flows.size();
+            flows.emplace_back(&network->flowTable);
+            state.push_back(0);
+            network->bgFlowManager.push_back(&flows[i]);
+        }
+        Flow& flow = flows[i];
+        flow.srcId = record.src;
+        flow.dstId = record.dst;
+        flow.linkClass = LINK_NET;
+        RandomStream rng = network->stream(RNG_TRACE, index);
+        flow.setPath(network->ecmpPath(record.src, record.dst, rng.below(network->ecmpPathNum(record.src, record.dst))));
+        flow.dataSize() = record.bytes * 8.0 / (1024 * 1024);
+        flow.rate() = 0;
+        flow.sentDataSize() = 0;
+        flow.completionTime() = 0;
+        state[i] = 1;
+        live.push_back(i);
+        replayed++;
+    }
+}
\ No newline at end of file
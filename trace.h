@@ -0,0 +1,99 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "network.h"
+#include "stats.h"
+
+/*
+背景流量trace文件（小端）：
+    char magic[4] = "BGTR"，uint32 version = 1，uint64 recordNum
+    之后recordNum条TraceRecord，按time从小到大排列
+time的单位与模拟的时间相同（unitTime），src/dst为拓扑里的gpu或leaf编号，bytes为字节数
+*/
+struct TraceRecord {
+    double time;
+    int32_t src;
+    int32_t dst;
+    uint64_t bytes;
+};
+
+/*
+只读的trace文件，按窗口做内存映射
+每次只映射windowSize大小的一段，读到窗口外的记录时解除映射并映射下一段，
+几十GB的trace也只占用一个窗口的地址空间和内存
+*/
+class TraceFile {
+public:
+    static constexpr size_t headerSize = 16;
+
+    uint64_t recordNum = 0;
+    uint64_t cursor = 0;      // 下一条要读的记录
+    uint64_t fileSize = 0;
+    size_t windowSize = 64 << 20;
+
+    // 当前映射的窗口：文件里 [windowBegin, windowEnd) 映射在base
+    const char* base = nullptr;
+    uint64_t windowBegin = 0;
+    uint64_t windowEnd = 0;
+
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    ~TraceFile();
+
+    // 打开文件并检查文件头，文件不存在或格式不对时返回false
+    bool open(const std::string& path, size_t windowSize);
+
+    // 读取下一条记录但不前进，没有记录时返回false
+    bool peek(TraceRecord& record);
+
+    void close();
+
+    // 映射包含offset处一条记录的窗口
+    void map(uint64_t offset);
+
+    void unmap();
+};
+
+/*
+trace回放：模拟时间到达记录的time时，把记录作为一个背景流量加入bgFlowManager
+1. 路径为src和dst之间的一条等价最短路径，第k条记录的选择来自network.stream(RNG_TRACE, k)
+2. 发送完的flow在下一次updateRate把它从link上移除之后回收，新的记录复用它在FlowTable里的位置，
+   flow的数量只与同时在发送的记录数量有关，与trace的长度无关
+3. 发送完时把completionTime加到fctStats里
+*/
+class TraceReplay {
+public:
+    Network* network = nullptr;
+    TraceFile file;
+
+    // 回放使用的flow，deque保证加入bgFlowManager的指针不会失效
+    std::deque<Flow> flows;
+    // state[i]：0 空闲，1 正在发送，2 发送完等待从link上移除
+    std::vector<char> state;
+    std::vector<int> live;      // 正在发送或等待移除的flow
+    std::vector<int> freeSlots; // 空闲的flow
+
+    uint64_t replayed = 0; // 已经加入的记录数量
+    uint64_t skipped = 0;  // src/dst不合法或bytes为0而跳过的记录数量
+
+    // 打开trace文件，文件不存在或格式不对时返回false
+    bool open(const std::string& path, Network* network, size_t windowSize = 64 << 20);
+
+    // 下一条记录的到达时间，没有记录时返回FLOAT_MAX
+    float nextArrival();
+
+    // 在step之后调用：记录发送完的flow的FCT并回收flow，加入time之前到达的所有记录
+    void advance(float time, FctStats* fctStats, int kind, int stage);
+};
+
+#endif // TRACE_H
\ No newline at end of file
@@ -0,0 +1,230 @@
+#include "traffic.h"
+#include "simulation.h"
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+const double pi = 3.14159265358979323846;
+
+// 经验分布，大小为1460字节的包的数量
+const double webSearchPackets[] = {6, 6, 13, 19, 33, 53, 133, 667, 1333, 3333, 6667, 20000};
+const double webSearchProb[] = {0, 0.15, 0.2, 0.3, 0.4, 0.53, 0.6, 0.7, 0.8, 0.9, 0.97, 1};
+const double dataMiningPackets[] = {1, 1, 2, 3, 7, 267, 2107, 66667, 666667};
+const double dataMiningProb[] = {0, 0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 0.99, 1};
+
+// 指数分布，均值为mean
+double exponential(RandomStream& rng, double mean) {
+    return -mean * std::log(1 - rng.uniform());
+}
+
+}
+
+/*
+目标：
+    根据config初始化每个背景流量的到达过程
+思路：
+    1. 经验分布换算成Mb（1460字节一个包，1MB = 8Mb），平均大小按分段线性的CDF求出；其他分布的平均大小为bgFlowSize，
+       没有设置时与原来的突发大小相同：gpuDataSize * 4.5 / bgFlowDataSizeRatio
+    2. 每个flow的平均到达间隔：bgFlowLoad > 0时为 平均大小 / (bgFlowLoad * 路径上最小的 linkBW / link上背景流量的数量)，
+       即几个背景流量经过同一条link时平分它的bgFlowLoad，最拥挤的link上背景流量的总负载为 bgFlowLoad * linkBW；否则为bgFlowPeriod
+       间隔不是正数（例如平均大小为0）时报错，这个flow没有到达事件，避免事件都停在同一个时刻
+    3. 第一个事件在start之后：Periodic在下一个周期的整数倍；Poisson按指数分布；OnOff按on的时间比例随机选择初始状态
+       start不为0用于从checkpoint恢复时换一组到达过程的参数继续模拟
+    4. 随机数来自network.stream(RNG_BG_FLOW_BURST, i)，Periodic + Uniform与原来的突发完全相同
+*/
+void BgTraffic::init(const SimConfig& config, Network& network, std::vector<Flow>& flows, double start) {
+    this->flows = &flows;
+    arrival = config.bgFlowArrival;
+    sizeDist = config.bgFlowSizeDist;
+    gpuDataSize = config.gpuDataSize;
+    dataSizeRatio = config.bgFlowDataSizeRatio;
+    shape = config.bgFlowSizeShape;
+    onTime = config.bgFlowOnTime;
+    offTime = config.bgFlowOffTime;
+    events = decltype(events)();
+
+    // 1. 数据大小的分布
+    cdfSize.clear();
+    cdfProb.clear();
+    if (sizeDist == SizeDist::WebSearch || sizeDist == SizeDist::DataMining) {
+        bool web = sizeDist == SizeDist::WebSearch;
+        int pointNum = web ? 12 : 9;
+        for (int k = 0; k < pointNum; k++) {
+            cdfSize.push_back((web ? webSearchPackets[k] : dataMiningPackets[k]) * 1460 * 8 / (1024 * 1024));
+            cdfProb.push_back(web ? webSearchProb[k] : dataMiningProb[k]);
+        }
+        meanSize = 0;
+        for (int k = 0; k + 1 < pointNum; k++) {
+            meanSize += (cdfProb[k + 1] - cdfProb[k]) * (cdfSize[k] + cdfSize[k + 1]) / 2;
+        }
+    }
+    else if (sizeDist != SizeDist::Uniform && config.bgFlowSize > 0) {
+        meanSize = config.bgFlowSize;
+    }
+    else {
+        meanSize = config.gpuDataSize * 4.5 / config.bgFlowDataSizeRatio;
+    }
+
+    // 2. 每个flow的到达间隔
+    int flowNum = flows.size();
+    rng.clear();
+    interval.assign(flowNum, config.bgFlowPeriod);
+    on.assign(flowNum, 1);
+    onEnd.assign(flowNum, 0);
+    periods.assign(flowNum, 0);
+    std::vector<int> linkFlows(config.bgFlowLoad > 0 ? network.linkBW.size() : 0, 0);
+    for (int i = 0; i < flowNum && config.bgFlowLoad > 0; i++) {
+        const std::vector<int>& path = flows[i].path;
+        for (size_t j = 0; j + 1 < path.size(); j++) {
+            linkFlows[network.linkId(path[j], path[j + 1])]++;
+        }
+    }
+    int invalid = 0;
+    for (int i = 0; i < flowNum; i++) {
+        rng.push_back(network.stream(RNG_BG_FLOW_BURST, i));
+        if (config.bgFlowLoad > 0) {
+            double share = FLOAT_MAX;
+            const std::vector<int>& path = flows[i].path;
+            for (size_t j = 0; j + 1 < path.size(); j++) {
+                int l = network.linkId(path[j], path[j + 1]);
+                share = std::min(share, (double)network.linkBW[l] / linkFlows[l]);
+            }
+            interval[i] = meanSize / (config.bgFlowLoad * share);
+        }
+        if (!(interval[i] > 0) || !std::isfinite(interval[i])) {
+            interval[i] = 0;
+            invalid++;
+        }
+    }
+    if (invalid > 0) {
+        std::cerr << "background arrival interval must be positive (bgFlowPeriod, bgFlowSize, bgFlowLoad), "
+                  << invalid << " flows have no arrivals" << std::endl;
+    }
+
+    // 3. 第一个事件
+    for (int i = 0; i < flowNum; i++) {
+        if (arrival == ArrivalProcess::OnOff) {
+            on[i] = rng[i].uniform() < onTime / (onTime + offTime);
+            if (on[i]) {
+                onEnd[i] = start + exponential(rng[i], onTime);
+                events.push({onEnd[i], i, true});
+                scheduleArrival(i, start);
+            }
+            else {
+                events.push({start + exponential(rng[i], offTime), i, true});
+            }
+        }
+        else if (interval[i] > 0) {
+            periods[i] = std::floor(start / interval[i]);
+            scheduleArrival(i, start);
+        }
+    }
+}
+
+/*
+目标：
+    安排flow i在now之后的下一次到达
+思路：
+    1. Periodic：第k次到达在 k * interval，不累加误差
+    2. Poisson：间隔服从均值为interval的指数分布
+    3. OnOff：on时的到达率提高到 (onTime + offTime) / onTime 倍，使平均到达率不变；超过onEnd时不安排，等下一次on
+    间隔为0的flow（见init）不安排到达
+*/
+void BgTraffic::scheduleArrival(int i, double now) {
+    if (interval[i] <= 0) {
+        return;
+    }
+    if (arrival == ArrivalProcess::Periodic) {
+        periods[i]++;
+        events.push({periods[i] * interval[i], i, false});
+    }
+    else if (arrival == ArrivalProcess::Poisson) {
+        events.push({now + exponential(rng[i], interval[i]), i, false});
+    }
+    else {
+        double time = now + exponential(rng[i], interval[i] * onTime / (onTime + offTime));
+        if (time < onEnd[i]) {
+            events.push({time, i, false});
+        }
+    }
+}
+
+double BgTraffic::nextEventTime() {
+    if (events.empty()) {
+        return FLOAT_MAX;
+    }
+    return events.top().time;
+}
+
+/*
+目标：
+    处理所有不晚于time的事件
+思路：
+    1. time是float，与事件的时刻比较时允许几个ulp的误差，避免循环停在事件之前
+    2. 到达：把sampleSize加到flow的dataSize里，安排下一次到达；flow原来没有数据时记录到达的时刻，
+       flow还在发送时新的数据接在后面，FCT从这段连续发送的第一次到达开始计算
+    3. on/off切换：进入on时安排on的结束和第一次到达，进入off时安排off的结束
+*/
+void BgTraffic::advance(double time, std::vector<float>* arrivalTime) {
+    double tolerance = 1e-6 * (std::fabs(time) + 1);
+    while (!events.empty() && events.top().time <= time + tolerance) {
+        Event event = events.top();
+        events.pop();
+        int i = event.flow;
+        if (!event.toggle) {
+            Flow& flow = (*flows)[i];
+            if (arrivalTime && flow.dataSize() <= 0) {
+                (*arrivalTime)[i] = event.time;
+            }
+            flow.dataSize() += (float)sampleSize(i);
+            scheduleArrival(i, event.time);
+        }
+        else if (!on[i]) {
+            on[i] = 1;
+            onEnd[i] = event.time + exponential(rng[i], onTime);
+            events.push({onEnd[i], i, true});
+            scheduleArrival(i, event.time);
+        }
+        else {
+            on[i] = 0;
+            events.push({event.time + exponential(rng[i], offTime), i, true});
+        }
+    }
+}
+
+/*
+目标：
+    flow i一次到达的数据大小，单位Mb
+思路：
+    1. Uniform与原来的突发相同，用float计算
+    2. Pareto：xm = mean * (shape - 1) / shape，x = xm / U^(1 / shape)
+    3. Lognormal：mu = ln(mean) - shape^2 / 2，Box-Muller得到标准正态分布
+    4. 经验分布：在分段线性的CDF上取逆
+*/
+double BgTraffic::sampleSize(int i) {
+    if (sizeDist == SizeDist::Uniform) {
+        float size = gpuDataSize * rng[i].below(10) / dataSizeRatio;
+        return size;
+    }
+    if (sizeDist == SizeDist::Fixed) {
+        return meanSize;
+    }
+    if (sizeDist == SizeDist::Pareto) {
+        double xm = shape > 1 ? meanSize * (shape - 1) / shape : meanSize;
+        return xm / std::pow(1 - rng[i].uniform(), 1 / shape);
+    }
+    if (sizeDist == SizeDist::Lognormal) {
+        double mu = std::log(meanSize) - shape * shape / 2;
+        double z = std::sqrt(-2 * std::log(1 - rng[i].uniform())) * std::cos(2 * pi * rng[i].uniform());
+        return std::exp(mu + shape * z);
+    }
+    double u = rng[i].uniform();
+    size_t k = 1;
+    while (k + 1 < cdfProb.size() && cdfProb[k] < u) {
+        k++;
+    }
+    double span = cdfProb[k] - cdfProb[k - 1];
+    double fraction = span > 0 ? (u - cdfProb[k - 1]) / span : 1;
+    return cdfSize[k - 1] + fraction * (cdfSize[k] - cdfSize[k - 1]);
+}
\ No newline at end of file
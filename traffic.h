@@ -0,0 +1,85 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <functional>
+#include <queue>
+#include <vector>
+#include "flow.h"
+#include "network.h"
+#include "rng.h"
+
+struct SimConfig;
+
+// 背景流量的到达过程
+enum class ArrivalProcess {
+    Periodic, // 每隔一个周期到达一次，所有flow同时到达（原来的突发方式）
+    Poisson,  // 到达间隔服从指数分布
+    OnOff     // 两状态Markov：on时按Poisson到达，off时没有到达，on/off的持续时间服从指数分布
+};
+
+// 每次到达的数据大小的分布
+enum class SizeDist {
+    Uniform,    // gpuDataSize * (0 ~ 9) / bgFlowDataSizeRatio（原来的突发大小）
+    Fixed,      // 固定为bgFlowSize
+    Pareto,     // 均值为bgFlowSize，形状参数为bgFlowSizeShape（需要大于1）
+    Lognormal,  // 均值为bgFlowSize，对数的标准差为bgFlowSizeShape
+    WebSearch,  // DCTCP论文里web search的经验分布
+    DataMining  // VL2论文里data mining的经验分布
+};
+
+/*
+背景流量的到达事件
+1. 每个背景流量有自己的到达过程参数（到达率，on/off状态）和随机数stream，到达作为离散事件放在最小堆里，与tick无关
+2. 模拟循环不会跳过下一个事件的时刻；处理事件时把数据加到flow的dataSize里
+3. bgFlowLoad > 0时，每个flow的平均到达率 = bgFlowLoad * 路径上最小的(linkBW / link上背景流量的数量) / 平均数据大小，
+   共享同一条瓶颈link的背景流量平分它的bgFlowLoad，这条link上背景流量的总负载为它容量的bgFlowLoad；否则平均到达间隔为bgFlowPeriod
+*/
+class BgTraffic {
+public:
+    struct Event {
+        double time;
+        int flow;
+        bool toggle; // true表示on/off状态切换，false表示一次到达
+        bool operator>(const Event& other) const { return time > other.time; }
+    };
+
+    std::vector<Flow>* flows = nullptr;
+    ArrivalProcess arrival = ArrivalProcess::Periodic;
+    SizeDist sizeDist = SizeDist::Uniform;
+    float gpuDataSize = 1024;
+    int dataSizeRatio = 600;
+    double meanSize = 0;
+    double shape = 1.2;
+    double onTime = 1000;
+    double offTime = 1000;
+
+    // 每个flow的参数和状态
+    std::vector<RandomStream> rng;
+    std::vector<double> interval; // 平均到达间隔（Periodic时为周期），0表示没有到达
+    std::vector<char> on;
+    std::vector<double> onEnd;  // on状态结束的时刻
+    std::vector<long long> periods; // Periodic时已经到达的次数
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+
+    // 经验分布：数据大小（Mb）和累计概率
+    std::vector<double> cdfSize;
+    std::vector<double> cdfProb;
+
+    // 根据config初始化每个flow的到达过程，安排start之后的第一个事件
+    void init(const SimConfig& config, Network& network, std::vector<Flow>& flows, double start = 0);
+
+    // 下一个事件的时刻，没有事件时返回FLOAT_MAX
+    double nextEventTime();
+
+    // 处理所有不晚于time的事件；arrivalTime不为空时，数据到达空闲的flow i时把到达的时刻记在arrivalTime[i]里
+    void advance(double time, std::vector<float>* arrivalTime = nullptr);
+
+    // flow i的一次到达的数据大小
+    double sampleSize(int i);
+
+    // 安排flow i在now之后的下一次到达
+    void scheduleArrival(int i, double now);
+};
+
+#endif // TRAFFIC_H
\ No newline at end of file
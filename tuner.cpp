@@ -0,0 +1,287 @@
+#include "tuner.h"
+#include "rng.h"
+#include "session.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+
+// 调优时不写任何文件，每个模拟单线程运行，并行在不同的点之间
+static SimConfig searchConfig(const SimConfig& config) {
+    SimConfig search = config;
+    search.printFlows = false;
+    search.telemetryFile.clear();
+    search.checkpointFile.clear();
+    search.restoreFile.clear();
+    search.tickThreads = 1;
+    return search;
+}
+
+/*
+目标：
+    估计每个gpu的NVLink和Net带宽，得到两类link同时发送完的分配比例和chunk大小
+思路：
+    1. 用config调用SimSession::setup创建拓扑，路由和背景流量，不运行模拟
+    2. 背景流量i的平均速率 = 平均数据大小 / 平均到达间隔，累加到它经过的每条link上；trace回放的流量无法预先知道，不计入
+    3. gpu的Net flow在link l上的可用带宽 = max(linkBW - 背景负载, 所有背景流量都在发送时的公平份额) / link上gpu flow的数量，
+       取路径上的最小值；ring step在最慢的gpu完成时结束，Net带宽取所有gpu里最小的
+    4. 数据按 ratio = NVLink / (NVLink + Net) 分配时两类link同时发送完，step时间 T = len / (NVLink + Net)
+    5. chunk越大，最后一个chunk造成的不平衡越大（约chunkTime / 2）；chunk越小，每个chunk至少一个unitTime的决策开销越多（约 T * unitTime / chunkTime），
+       两者之和最小时 chunkTime = sqrt(2 * T * unitTime)
+*/
+SplitEstimate estimateSplit(const SimConfig& config) {
+    // 1. 创建拓扑和背景流量
+    SimSession session;
+    session.setup(searchConfig(config));
+    Network& network = session.network;
+
+    // 2. 每条link上背景流量的平均负载
+    std::vector<double> bgLoad(network.linkBW.size(), 0);
+    std::vector<int> bgFlowNum(network.linkBW.size(), 0);
+    for (size_t i = 0; i < session.bgFlows.size(); i++) {
+        double rate = session.traffic.meanSize / session.traffic.interval[i];
+        for (int l : session.bgFlows[i].links) {
+            bgLoad[l] += rate;
+            bgFlowNum[l]++;
+        }
+    }
+
+    // 3. gpu的Net可用带宽，不包括经过NVSwitch的NVLink flow
+    std::vector<int> gpuFlowNum(network.linkBW.size(), 0);
+    for (auto& flow : network.gpuFlowManager) {
+        if (flow->linkClass == LINK_NVLINK) {
+            continue;
+        }
+        for (int l : flow->links) {
+            gpuFlowNum[l]++;
+        }
+    }
+    SplitEstimate estimate;
+    estimate.nvlinkBW = config.NVLinkBandwidth;
+    estimate.netBW = FLOAT_MAX;
+    for (auto& flow : network.gpuFlowManager) {
+        if (flow->linkClass == LINK_NVLINK) {
+            continue;
+        }
+        for (int l : flow->links) {
+            double share = network.linkBW[l] * gpuFlowNum[l] / (gpuFlowNum[l] + bgFlowNum[l]);
+            double available = std::max(network.linkBW[l] - bgLoad[l], share) / gpuFlowNum[l];
+            estimate.netBW = std::min(estimate.netBW, (float)available);
+            estimate.bgLoad = std::max(estimate.bgLoad, (float)(bgLoad[l] / network.linkBW[l]));
+        }
+    }
+    if (estimate.netBW == FLOAT_MAX) {
+        estimate.netBW = config.topoBW;
+    }
+
+    // 4. 分配比例和step时间
+    float len = config.len >= 0 ? config.len : config.gpuDataSize;
+    estimate.ratio = estimate.nvlinkBW / (estimate.nvlinkBW + estimate.netBW);
+    estimate.stepTime = len / (estimate.nvlinkBW + estimate.netBW);
+
+    // 5. chunk的发送时间
+    estimate.chunkTime = std::min(estimate.stepTime, std::sqrt(2 * estimate.stepTime * config.unitTime));
+    return estimate;
+}
+
+// 两类link的chunk都发送chunkTime，初始窗口为一个chunk；alpha = 0不扩大窗口，delta为一个chunk的预期间隔
+SimConfig analyticalConfig(const SimConfig& config, const SplitEstimate& estimate) {
+    SimConfig start = config;
+    start.ratio = estimate.ratio;
+    start.Cnvl = estimate.nvlinkBW * estimate.chunkTime;
+    start.Cnet = estimate.netBW * estimate.chunkTime;
+    start.Wnvl = start.Cnvl;
+    start.Wnet = start.Cnet;
+    start.alpha = 0;
+    start.delta = estimate.chunkTime;
+    return start;
+}
+
+// chunk和窗口不超过len，最小为len / 4096；delta在 unitTime / 16 到 16个step时间之间
+// ScheduleCollective的算法按ratio分配server内的数据，只调优ratio
+std::vector<TuneParam> tuneParams(const SimConfig& config, const SplitEstimate& estimate) {
+    if (config.mode == SplitMode::Ratio || !config.jobs.empty() ||
+        (config.collective != Collective::Ring && config.collective != Collective::AllReduce)) {
+        return {{"ratio", &SimConfig::ratio, 0, 1, false, 0.1}};
+    }
+    double len = config.len >= 0 ? config.len : config.gpuDataSize;
+    return {
+        {"Cnvl", &SimConfig::Cnvl, len / 4096, len, true, 1},
+        {"Cnet", &SimConfig::Cnet, len / 4096, len, true, 1},
+        {"Wnvl", &SimConfig::Wnvl, len / 4096, len, true, 1},
+        {"Wnet", &SimConfig::Wnet, len / 4096, len, true, 1},
+        {"alpha", &SimConfig::alpha, 0, 4, false, 0.5},
+        {"delta", &SimConfig::delta, config.unitTime / 16, std::max(estimate.stepTime * 16, config.unitTime), true, 1},
+    };
+}
+
+/*
+目标：
+    在线程池里并行运行一组点，返回每个点在所有种子上的平均完成时间
+思路：
+    1. 每个点运行replicas次，replicas大于1时第k次的种子取config.seed下RNG_REPLICA的第k个stream，
+       所有点使用同一组种子（公共随机数），点之间的差别不受背景流量随机性的影响
+    2. 结果写到自己的位置，不需要加锁；模拟不能运行时完成时间为FLOAT_MAX
+*/
+static std::vector<float> evaluate(ThreadPool& pool, const std::vector<SimConfig>& points, int replicas, int& evaluations) {
+    // 1. 每个点的每个种子
+    replicas = std::max(replicas, 1);
+    std::vector<SimConfig> configs;
+    for (auto& point : points) {
+        for (int k = 0; k < replicas; k++) {
+            SimConfig config = point;
+            if (replicas > 1) {
+                config.seed = replicaSeed(point.seed, k);
+            }
+            configs.push_back(config);
+        }
+    }
+    std::vector<SimResult> results(configs.size());
+    for (size_t i = 0; i < configs.size(); i++) {
+        pool.submit([&configs, &results, i] {
+            results[i] = runSimulation(configs[i]);
+        });
+    }
+    pool.wait();
+    evaluations += configs.size();
+
+    // 2. 平均完成时间
+    std::vector<float> times(points.size(), 0);
+    for (size_t p = 0; p < points.size(); p++) {
+        for (int k = 0; k < replicas; k++) {
+            const SimResult& result = results[p * replicas + k];
+            if (!result.error.empty()) {
+                times[p] = FLOAT_MAX;
+                break;
+            }
+            times[p] += result.time / replicas;
+        }
+    }
+    return times;
+}
+
+// 搜索空间里的坐标：logScale的参数为log2(值)，其他为值本身
+static std::vector<double> coordsOf(const SimConfig& config, const std::vector<TuneParam>& params) {
+    std::vector<double> x;
+    for (auto& param : params) {
+        double value = std::min(std::max((double)(config.*param.field), param.lower), param.upper);
+        x.push_back(param.logScale ? std::log2(value) : value);
+    }
+    return x;
+}
+
+static SimConfig configOf(const SimConfig& base, const std::vector<TuneParam>& params, const std::vector<double>& x) {
+    SimConfig config = base;
+    for (size_t d = 0; d < params.size(); d++) {
+        config.*params[d].field = params[d].logScale ? std::exp2(x[d]) : x[d];
+    }
+    return config;
+}
+
+/*
+目标：
+    找到完成时间最小的分配方式参数
+思路：
+    1. 解析模型给出起点；shortRuns且为allReduce时，搜索阶段的config只模拟第一个ring step
+    2. 模式搜索：每一轮在当前点的每个坐标上 +step 和 -step（超出范围时截断到边界）得到最多2 * 维数个候选点，并行运行；
+       有更好的点时移动到最好的点，否则所有步长减半；步长减半shrinkNum次或者点数超过maxEvaluations时结束
+    3. 搜索过的点按短模拟的时间排序，取最好的verifyNum个，加上解析起点和原来的config，用完整的config并行运行，
+       取完成时间最小的；原来的config最好时结果就是原来的config
+*/
+TuneResult tuneConfig(const SimConfig& config, const TuneOptions& options, std::ostream* log) {
+    TuneResult result;
+    ThreadPool pool(options.threadNum);
+    SimConfig base = searchConfig(config);
+
+    // 1. 解析模型的起点，搜索阶段的config
+    result.estimate = estimateSplit(base);
+    result.analytical = analyticalConfig(base, result.estimate);
+    SimConfig shortBase = base;
+    if (options.shortRuns && base.collective == Collective::AllReduce) {
+        shortBase.collective = Collective::Ring;
+    }
+    std::vector<TuneParam> params = tuneParams(base, result.estimate);
+    std::vector<double> x = coordsOf(result.analytical, params);
+    std::vector<double> step;
+    for (auto& param : params) {
+        step.push_back(param.step);
+    }
+    std::vector<std::pair<float, std::vector<double>>> history;
+    float fx = evaluate(pool, {configOf(shortBase, params, x)}, options.replicas, result.evaluations)[0];
+    history.push_back({fx, x});
+    int searched = 1;
+
+    // 2. 模式搜索
+    int shrink = 0;
+    while (shrink < options.shrinkNum && searched < options.maxEvaluations) {
+        result.iterations++;
+        std::vector<std::vector<double>> candidates;
+        for (size_t d = 0; d < params.size(); d++) {
+            double lower = params[d].logScale ? std::log2(params[d].lower) : params[d].lower;
+            double upper = params[d].logScale ? std::log2(params[d].upper) : params[d].upper;
+            for (int sign = -1; sign <= 1; sign += 2) {
+                std::vector<double> y = x;
+                y[d] = std::min(std::max(x[d] + sign * step[d], lower), upper);
+                if (y[d] != x[d]) {
+                    candidates.push_back(y);
+                }
+            }
+        }
+        std::vector<SimConfig> points;
+        for (auto& y : candidates) {
+            points.push_back(configOf(shortBase, params, y));
+        }
+        std::vector<float> times = evaluate(pool, points, options.replicas, result.evaluations);
+        searched += candidates.size();
+
+        int bestCandidate = -1;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            history.push_back({times[i], candidates[i]});
+            if (times[i] < fx && (bestCandidate < 0 || times[i] < times[bestCandidate])) {
+                bestCandidate = i;
+            }
+        }
+        if (bestCandidate >= 0) {
+            x = candidates[bestCandidate];
+            fx = times[bestCandidate];
+        }
+        else {
+            for (auto& s : step) {
+                s /= 2;
+            }
+            shrink++;
+        }
+        if (log) {
+            *log << "# iteration " << result.iterations << ": time = " << fx;
+            for (size_t d = 0; d < params.size(); d++) {
+                *log << " " << params[d].name << " = " << (params[d].logScale ? std::exp2(x[d]) : x[d]);
+            }
+            *log << std::endl;
+        }
+    }
+
+    // 3. 用完整的config验证
+    std::stable_sort(history.begin(), history.end(),
+                     [](const std::pair<float, std::vector<double>>& a, const std::pair<float, std::vector<double>>& b) {
+                         return a.first < b.first;
+                     });
+    std::vector<std::vector<double>> chosen;
+    std::vector<SimConfig> finalists;
+    for (auto& item : history) {
+        if ((int)chosen.size() >= options.verifyNum) {
+            break;
+        }
+        if (std::find(chosen.begin(), chosen.end(), item.second) == chosen.end()) {
+            chosen.push_back(item.second);
+            finalists.push_back(configOf(base, params, item.second));
+        }
+    }
+    finalists.push_back(result.analytical);
+    finalists.push_back(base);
+    std::vector<float> times = evaluate(pool, finalists, options.replicas, result.evaluations);
+    result.analyticalTime = times[finalists.size() - 2];
+    result.baselineTime = times[finalists.size() - 1];
+    int best = std::min_element(times.begin(), times.end()) - times.begin();
+    result.best = finalists[best];
+    result.bestTime = times[best];
+    return result;
+}
\ No newline at end of file
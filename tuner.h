@@ -0,0 +1,69 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "simulation.h"
+
+/*
+NVLink/Net分配方式和滑动窗口参数的自动调优，代替各个场景里手工给出的 ratio = 0.8，Cnvl = NVLinkBandwidth * 70 等取值
+1. 解析模型：按拓扑和背景流量的平均负载估计每个gpu的Net可用带宽，给出使两类link同时发送完的分配比例和chunk大小，作为搜索的起点
+2. 无导数搜索：从起点开始做坐标方向的模式搜索（compass search），每一轮的候选点在线程池里并行运行短模拟
+3. 验证：短模拟里最好的几个点，解析起点和原来的config用完整的config再运行一次，完成时间最小的作为结果
+调优只改变分配方式的参数，拓扑，gpuDataSize和背景流量都与给出的config相同
+*/
+
+// 一个被调优的参数：SimConfig里的成员，取值范围，是否在log2空间里搜索，初始步长（log2空间里为倍数的log2）
+struct TuneParam {
+    std::string name;
+    float SimConfig::*field;
+    double lower;
+    double upper;
+    bool logScale;
+    double step;
+};
+
+struct TuneOptions {
+    int threadNum = 0;        // 线程池的线程数，0为硬件线程数
+    int replicas = 1;         // 每个点用几个种子取平均，大于1时第k个种子由config.seed和k派生（与Sweep相同）
+    int maxEvaluations = 400; // 搜索阶段最多的点数（不含重复的种子）
+    int shrinkNum = 5;        // 步长减半的次数，之后结束搜索
+    int verifyNum = 4;        // 用完整的config验证的候选点数量
+    bool shortRuns = true;    // allReduce时搜索阶段只模拟第一个ring step
+};
+
+// 解析模型的估计
+struct SplitEstimate {
+    float nvlinkBW = 0;  // 每个gpu的NVLink带宽
+    float netBW = 0;     // 每个gpu扣除背景流量之后的Net可用带宽，取所有gpu里最小的
+    float bgLoad = 0;    // gpu的Net路径上背景流量的平均负载（占linkBW的比例），取最大的link
+    float ratio = 0;     // NVLink / (NVLink + Net)
+    float stepTime = 0;  // 一个step的估计时间
+    float chunkTime = 0; // 每个chunk的发送时间
+};
+
+struct TuneResult {
+    SimConfig best;
+    SimConfig analytical;
+    SplitEstimate estimate;
+    float bestTime = 0;
+    float analyticalTime = 0;
+    float baselineTime = 0; // 原来的config的完成时间
+    int evaluations = 0;    // 运行的模拟次数（含重复的种子和验证）
+    int iterations = 0;
+};
+
+// config.mode下被调优的参数：ratio或者ScheduleCollective的算法时只有ratio，滑动窗口时为Cnvl，Cnet，Wnvl，Wnet，alpha，delta
+std::vector<TuneParam> tuneParams(const SimConfig& config, const SplitEstimate& estimate);
+
+// 解析模型：估计Net的可用带宽和一个step的时间
+SplitEstimate estimateSplit(const SimConfig& config);
+
+// 解析模型给出的config：按估计的带宽设置ratio或chunk和窗口
+SimConfig analyticalConfig(const SimConfig& config, const SplitEstimate& estimate);
+
+// 调优config的分配方式参数，log不为空时打印每一轮搜索的进度
+TuneResult tuneConfig(const SimConfig& config, const TuneOptions& options, std::ostream* log = nullptr);
+
+#endif // TUNER_H
\ No newline at end of file